@@ -3,9 +3,10 @@ CONFIG += console c++17
 CONFIG -= app_bundle
 CONFIG -= qt
 
-unix: LIBS += -ltbb -lpthread
+unix: LIBS += -ltbb -lpthread -lz
 
 SOURCES += \
+        compression.cpp \
         transport_router.cpp \
         transport_catalogue.cpp \
 	domain.cpp \
@@ -15,10 +16,14 @@ SOURCES += \
         json_builder.cpp \
 	main.cpp \
 	map_renderer.cpp \
+	query_server.cpp \
+	raptor_router.cpp \
 	request_handler.cpp \
+	spatial_index.cpp \
 	svg.cpp
 
 HEADERS += \
+        compression.h \
     test_queries.h \
         transport_router.h \
         transport_catalogue.h \
@@ -28,7 +33,10 @@ HEADERS += \
 	json_reader.h \
         json_builder.h \
 	map_renderer.h \
+	query_server.h \
+	raptor_router.h \
 	request_handler.h \
+	spatial_index.h \
         svg.h \
         ranges.h \
         router.h \
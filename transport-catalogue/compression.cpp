@@ -0,0 +1,154 @@
+#include "compression.h"
+
+#include <cstdint>
+#include <stdexcept>
+
+namespace compression {
+
+using namespace std::literals;
+
+static constexpr std::string_view base64_alphabet =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"sv;
+
+std::optional<Format> ParseFormat(std::string_view name)
+{
+    if (name == "gzip"sv) {
+        return Format::Gzip;
+    } else if (name == "deflate"sv) {
+        return Format::Deflate;
+    }
+    return std::nullopt;
+}
+
+//======================================================================
+
+Base64Encoder::Base64Encoder(std::string &output)
+    : output_{output} {
+}
+
+void Base64Encoder::Write(const unsigned char *data, size_t size)
+{
+    const unsigned char* const end = data + size;
+    while (pending_size_ != 0 && data != end) {
+        pending_[pending_size_++] = *data++;
+        if (pending_size_ == pending_.size()) {
+            EncodeTriple(pending_.data());
+            pending_size_ = 0;
+        }
+    }
+
+    output_.reserve(output_.size() + (end - data) / 3 * 4 + 4);
+    for (; end - data >= 3; data += 3) {
+        EncodeTriple(data);
+    }
+
+    while (data != end) {
+        pending_[pending_size_++] = *data++;
+    }
+}
+
+void Base64Encoder::Finish()
+{
+    if (pending_size_ == 0) {
+        return;
+    }
+
+    const size_t size = pending_size_;
+    for (size_t i = size; i < pending_.size(); ++i) {
+        pending_[i] = 0;
+    }
+    EncodeTriple(pending_.data());
+    // Лишние символы последней группы заменяются выравниванием
+    output_.replace(output_.size() - (pending_.size() - size), pending_.size() - size,
+                    pending_.size() - size, '=');
+    pending_size_ = 0;
+}
+
+void Base64Encoder::EncodeTriple(const unsigned char *triple)
+{
+    const uint32_t value = (uint32_t(triple[0]) << 16) | (uint32_t(triple[1]) << 8) | triple[2];
+    output_.push_back(base64_alphabet[(value >> 18) & 0x3F]);
+    output_.push_back(base64_alphabet[(value >> 12) & 0x3F]);
+    output_.push_back(base64_alphabet[(value >> 6) & 0x3F]);
+    output_.push_back(base64_alphabet[value & 0x3F]);
+}
+
+//======================================================================
+
+DeflateBuffer::DeflateBuffer(Format format, std::string &output)
+    : encoder_{output}
+{
+    // Смещение 16 к размеру окна переключает zlib на вывод в формате gzip
+    const int window_bits = format == Format::Gzip ? MAX_WBITS + 16 : MAX_WBITS;
+    if (deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("compression: deflate initialization failed");
+    }
+    setp(input_.data(), input_.data() + input_.size());
+}
+
+DeflateBuffer::~DeflateBuffer()
+{
+    deflateEnd(&stream_);
+}
+
+void DeflateBuffer::Finish()
+{
+    if (finished_) {
+        return;
+    }
+    Deflate(pbase(), pptr() - pbase(), Z_FINISH);
+    setp(nullptr, nullptr);
+    encoder_.Finish();
+    finished_ = true;
+}
+
+DeflateBuffer::int_type DeflateBuffer::overflow(int_type ch)
+{
+    if (finished_) {
+        return traits_type::eof();
+    }
+
+    Deflate(pbase(), pptr() - pbase(), Z_NO_FLUSH);
+    setp(input_.data(), input_.data() + input_.size());
+
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+void DeflateBuffer::Deflate(const char *data, size_t size, int flush)
+{
+    stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream_.avail_in = static_cast<uInt>(size);
+
+    int result = Z_OK;
+    do {
+        stream_.next_out = output_.data();
+        stream_.avail_out = static_cast<uInt>(output_.size());
+        result = deflate(&stream_, flush);
+        if (result == Z_STREAM_ERROR) {
+            throw std::runtime_error("compression: deflate failed");
+        }
+        encoder_.Write(output_.data(), output_.size() - stream_.avail_out);
+    } while (stream_.avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+}
+
+//======================================================================
+
+// Базовый класс создаётся раньше buffer_, поэтому буфер подключается к потоку
+// только после того, как он сконструирован
+CompressedStream::CompressedStream(Format format, std::string &output)
+    : std::ostream(nullptr)
+    , buffer_{format, output} {
+    init(&buffer_);
+}
+
+void CompressedStream::Finish()
+{
+    flush();
+    buffer_.Finish();
+}
+
+}  // namespace compression
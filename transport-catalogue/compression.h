@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+#include <zlib.h>
+
+/*
+ * Сжатие выводимых данных на лету: байты, записанные в поток, сжимаются zlib
+ * небольшими порциями и сразу кодируются в base64, так что несжатый документ
+ * целиком в памяти не хранится.
+ */
+
+namespace compression {
+
+enum class Format {
+    Gzip,       ///< формат gzip (RFC 1952)
+    Deflate,    ///< формат zlib (RFC 1950), используемый в HTTP как "deflate"
+};
+
+///[\brief] Возвращает формат по названию "gzip" или "deflate", для прочих названий - std::nullopt
+std::optional<Format> ParseFormat(std::string_view name);
+
+// Накапливает base64-представление переданных байтов в строке
+class Base64Encoder {
+public:
+    explicit Base64Encoder(std::string& output);
+
+    void Write(const unsigned char* data, size_t size);
+    // Дописывает оставшиеся байты с выравниванием символами '='
+    void Finish();
+
+private:
+    void EncodeTriple(const unsigned char* triple);
+
+    std::string& output_;
+    std::array<unsigned char, 3> pending_{};
+    size_t pending_size_ = 0;
+};
+
+// Буфер потока, сжимающий записываемые данные и передающий результат в Base64Encoder
+class DeflateBuffer : public std::streambuf {
+public:
+    DeflateBuffer(Format format, std::string& output);
+    ~DeflateBuffer() override;
+
+    DeflateBuffer(const DeflateBuffer&) = delete;
+    DeflateBuffer& operator=(const DeflateBuffer&) = delete;
+
+    // Завершает сжатие. После вызова запись в буфер невозможна
+    void Finish();
+
+protected:
+    int_type overflow(int_type ch) override;
+
+private:
+    void Deflate(const char* data, size_t size, int flush);
+
+    static constexpr size_t buffer_size = 16 * 1024;
+
+    z_stream stream_{};
+    bool finished_ = false;
+    std::array<char, buffer_size> input_;
+    std::array<unsigned char, buffer_size> output_;
+    Base64Encoder encoder_;
+};
+
+// Поток вывода, содержимое которого сжимается и кодируется в base64 в строку output
+class CompressedStream : public std::ostream {
+public:
+    CompressedStream(Format format, std::string& output);
+
+    void Finish();
+
+private:
+    DeflateBuffer buffer_;
+};
+
+}  // namespace compression
@@ -23,3 +23,99 @@ svg::Point SphereProjector::operator()(geo::Coordinates coords) const {
                 (max_lat_ - coords.lat) * zoom_coeff_ + padding_
     };
 }
+
+void SphereProjector::operator()(const CoordinatesArray &coords, std::vector<double> &x, std::vector<double> &y) const
+{
+    const size_t size = coords.size();
+    x.resize(size);
+    y.resize(size);
+
+    const double* const lat = coords.lat.data();
+    const double* const lng = coords.lng.data();
+    double* const x_data = x.data();
+    double* const y_data = y.data();
+
+    const double min_lon = min_lon_;
+    const double max_lat = max_lat_;
+    const double zoom_coeff = zoom_coeff_;
+    const double padding = padding_;
+
+    for (size_t i = 0; i < size; ++i) {
+        x_data[i] = (lng[i] - min_lon) * zoom_coeff + padding;
+        y_data[i] = (max_lat - lat[i]) * zoom_coeff + padding;
+    }
+}
+
+SphereProjector::SphereProjector(const CoordinatesArray &points, double max_width, double max_height, double padding)
+    : padding_(padding)
+{
+    const size_t size = points.size();
+    if (size == 0) {
+        return;
+    }
+
+    const double* const lat = points.lat.data();
+    const double* const lng = points.lng.data();
+
+    // Границы по обеим осям вычисляются в одном проходе по массивам
+    double min_lon = lng[0];
+    double max_lon = lng[0];
+    double min_lat = lat[0];
+    double max_lat = lat[0];
+    for (size_t i = 1; i < size; ++i) {
+        min_lon = std::min(min_lon, lng[i]);
+        max_lon = std::max(max_lon, lng[i]);
+        min_lat = std::min(min_lat, lat[i]);
+        max_lat = std::max(max_lat, lat[i]);
+    }
+
+    SetBounds(min_lon, max_lon, min_lat, max_lat, max_width, max_height);
+}
+
+void SphereProjector::SetBounds(double min_lon, double max_lon, double min_lat, double max_lat,
+                                double max_width, double max_height)
+{
+    min_lon_ = min_lon;
+    max_lat_ = max_lat;
+
+    // Вычисляем коэффициент масштабирования вдоль координаты x
+    std::optional<double> width_zoom;
+    if (!IsZero(max_lon - min_lon_)) {
+        width_zoom = (max_width - 2 * padding_) / (max_lon - min_lon_);
+    }
+
+    // Вычисляем коэффициент масштабирования вдоль координаты y
+    std::optional<double> height_zoom;
+    if (!IsZero(max_lat_ - min_lat)) {
+        height_zoom = (max_height - 2 * padding_) / (max_lat_ - min_lat);
+    }
+
+    if (width_zoom && height_zoom) {
+        // Коэффициенты масштабирования по ширине и высоте ненулевые,
+        // берём минимальный из них
+        zoom_coeff_ = std::min(*width_zoom, *height_zoom);
+    } else if (width_zoom) {
+        // Коэффициент масштабирования по ширине ненулевой, используем его
+        zoom_coeff_ = *width_zoom;
+    } else if (height_zoom) {
+        // Коэффициент масштабирования по высоте ненулевой, используем его
+        zoom_coeff_ = *height_zoom;
+    }
+}
+
+size_t CoordinatesArray::size() const
+{
+    return lat.size();
+}
+
+void CoordinatesArray::reserve(size_t size)
+{
+    lat.reserve(size);
+    lng.reserve(size);
+}
+
+void CoordinatesArray::push_back(geo::Coordinates coords)
+{
+    lat.push_back(coords.lat);
+    lng.push_back(coords.lng);
+}
@@ -14,9 +14,12 @@
 
 #include <stdlib.h>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <iterator>
+#include <optional>
 
 #include "geo.h"
 #include "svg.h"
@@ -34,6 +37,12 @@ struct StopStat{
     Coordinates coordinates;
 };
 
+// Остановка рядом с заданной точкой
+struct NearbyStop{
+    std::string_view name;
+    double distance;
+};
+
 struct BusStat{
     std::string name;
     size_t stops_on_route;
@@ -46,6 +55,17 @@ struct BusStat{
 inline const double EPSILON = 1e-6;
 bool IsZero(double value);
 
+// Координаты набора точек в виде структуры массивов: широты и долготы хранятся
+// в отдельных непрерывных массивах, что позволяет обрабатывать их пакетно
+struct CoordinatesArray{
+    std::vector<double> lat;
+    std::vector<double> lng;
+
+    size_t size() const;
+    void reserve(size_t size);
+    void push_back(geo::Coordinates coords);
+};
+
 class SphereProjector {
 public:
     // points_begin и points_end задают начало и конец интервала элементов geo::Coordinates
@@ -59,49 +79,35 @@ public:
             return;
         }
 
-        // Находим точки с минимальной и максимальной долготой
-        const auto [left_it, right_it] = std::minmax_element(
-            points_begin, points_end,
-            [](auto lhs, auto rhs) { return lhs.lng < rhs.lng; });
-        min_lon_ = left_it->lng;
-        const double max_lon = right_it->lng;
-
-        // Находим точки с минимальной и максимальной широтой
-        const auto [bottom_it, top_it] = std::minmax_element(
-            points_begin, points_end,
-            [](auto lhs, auto rhs) { return lhs.lat < rhs.lat; });
-        const double min_lat = bottom_it->lat;
-        max_lat_ = top_it->lat;
-
-        // Вычисляем коэффициент масштабирования вдоль координаты x
-        std::optional<double> width_zoom;
-        if (!IsZero(max_lon - min_lon_)) {
-            width_zoom = (max_width - 2 * padding) / (max_lon - min_lon_);
+        // Находим минимальные и максимальные долготу и широту за один проход
+        double min_lon = points_begin->lng;
+        double max_lon = points_begin->lng;
+        double min_lat = points_begin->lat;
+        double max_lat = points_begin->lat;
+        for (auto it = std::next(points_begin); it != points_end; ++it) {
+            min_lon = std::min(min_lon, it->lng);
+            max_lon = std::max(max_lon, it->lng);
+            min_lat = std::min(min_lat, it->lat);
+            max_lat = std::max(max_lat, it->lat);
         }
 
-        // Вычисляем коэффициент масштабирования вдоль координаты y
-        std::optional<double> height_zoom;
-        if (!IsZero(max_lat_ - min_lat)) {
-            height_zoom = (max_height - 2 * padding) / (max_lat_ - min_lat);
-        }
-
-        if (width_zoom && height_zoom) {
-            // Коэффициенты масштабирования по ширине и высоте ненулевые,
-            // берём минимальный из них
-            zoom_coeff_ = std::min(*width_zoom, *height_zoom);
-        } else if (width_zoom) {
-            // Коэффициент масштабирования по ширине ненулевой, используем его
-            zoom_coeff_ = *width_zoom;
-        } else if (height_zoom) {
-            // Коэффициент масштабирования по высоте ненулевой, используем его
-            zoom_coeff_ = *height_zoom;
-        }
+        SetBounds(min_lon, max_lon, min_lat, max_lat, max_width, max_height);
     }
 
+    SphereProjector(const CoordinatesArray& points,
+                    double max_width, double max_height, double padding);
+
     // Проецирует широту и долготу в координаты внутри SVG-изображения
     svg::Point operator()(geo::Coordinates coords) const;
 
+    // Проецирует сразу все точки массива: x[i] и y[i] получают координаты i-й точки.
+    // Цикл не содержит ветвлений и зависимостей между итерациями и векторизуется компилятором
+    void operator()(const CoordinatesArray& coords, std::vector<double>& x, std::vector<double>& y) const;
+
 private:
+    void SetBounds(double min_lon, double max_lon, double min_lat, double max_lat,
+                   double max_width, double max_height);
+
     double padding_;
     double min_lon_ = 0;
     double max_lat_ = 0;
@@ -13,7 +13,7 @@ double ComputeDistance(Coordinates from, Coordinates to) {
     static const double dr = M_PI / 180.;
     return acos(sin(from.lat * dr) * sin(to.lat * dr)
                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-        * 6371000;
+        * EARTH_RADIUS;
 }
 
 }  // namespace geo
\ No newline at end of file
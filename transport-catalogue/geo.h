@@ -2,6 +2,9 @@
 
 namespace geo {
 
+// Радиус Земли в метрах
+inline constexpr double EARTH_RADIUS = 6371000;
+
 struct Coordinates {
     double lat; // Широта
     double lng; // Долгота
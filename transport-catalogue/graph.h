@@ -2,7 +2,11 @@
 
 #include "ranges.h"
 
+#include <cassert>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 namespace graph {
@@ -10,65 +14,167 @@ namespace graph {
 using VertexId = size_t;
 using EdgeId = size_t;
 
-template <typename Weight>
+template <typename Weight, typename Id = size_t>
 struct Edge {
-    VertexId from;
-    VertexId to;
+    Id from;
+    Id to;
     Weight weight;
 };
 
-template <typename Weight>
+// Исходящее ребро замороженного графа: конец и вес хранятся рядом с номером ребра,
+// чтобы обход не обращался к общему списку рёбер
+template <typename Weight, typename Id = size_t>
+struct OutgoingEdge {
+    Id id;
+    Id to;
+    Weight weight;
+};
+
+// Тип номеров вершин и рёбер задаётся параметром Id: 32-битные номера уменьшают рёбра
+// и таблицы маршрутизатора, если число вершин и рёбер заведомо меньше 2^32
+template <typename Weight, typename Id = size_t>
 class DirectedWeightedGraph {
+public:
+    using VertexId = Id;
+    using EdgeId = Id;
+
 private:
     using IncidenceList = std::vector<EdgeId>;
     using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+    using OutgoingEdgesRange = ranges::Range<const OutgoingEdge<Weight, Id>*>;
+
+    static_assert(std::is_arithmetic_v<Weight>, "Graph weights should be arithmetic");
+    static_assert(std::is_integral_v<Id> && std::is_unsigned_v<Id>, "Graph ids should be unsigned integers");
+    static_assert(std::numeric_limits<Id>::digits >= 16, "Graph ids should be at least 16 bits wide");
 
 public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
-    EdgeId AddEdge(const Edge<Weight>& edge);
+    EdgeId AddEdge(const Edge<Weight, Id>& edge);
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
-    const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    Edge<Weight, Id> GetEdge(EdgeId edge_id) const;
+    // Доступен до вызова Freeze
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+    ///[\brief] Завершает построение графа: исходящие рёбра всех вершин укладываются в один массив,
+    /// упорядоченный по началу ребра (CSR), а исходный список рёбер освобождается.
+    /// После этого рёбра добавлять нельзя
+    void Freeze();
+    bool IsFrozen() const;
+    // Исходящие рёбра в порядке добавления. Доступен после вызова Freeze
+    OutgoingEdgesRange GetOutgoingEdges(VertexId vertex) const;
+
 private:
-    std::vector<Edge<Weight>> edges_;
+    size_t vertex_count_ = 0;
+    // До вызова Freeze
+    std::vector<Edge<Weight, Id>> edges_;
     std::vector<IncidenceList> incidence_lists_;
+
+    // Начало ребра с номером id и его место в outgoing_edges_
+    struct EdgeLocation {
+        Id from;
+        Id position;
+    };
+
+    // После вызова Freeze. Исходящие рёбра вершины v занимают [outgoing_offsets_[v], outgoing_offsets_[v + 1]),
+    // ребро с номером id находится в outgoing_edges_[edge_locations_[id].position]
+    std::vector<size_t> outgoing_offsets_;
+    std::vector<OutgoingEdge<Weight, Id>> outgoing_edges_;
+    std::vector<EdgeLocation> edge_locations_;
 };
 
-template <typename Weight>
-DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-    : incidence_lists_(vertex_count) {
+template <typename Weight, typename Id>
+DirectedWeightedGraph<Weight, Id>::DirectedWeightedGraph(size_t vertex_count)
+    : vertex_count_(vertex_count)
+    , incidence_lists_(vertex_count) {
+    if (vertex_count > std::numeric_limits<Id>::max()) {
+        throw std::length_error("Too many vertices for the graph id type");
+    }
 }
 
-template <typename Weight>
-EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+template <typename Weight, typename Id>
+typename DirectedWeightedGraph<Weight, Id>::EdgeId
+DirectedWeightedGraph<Weight, Id>::AddEdge(const Edge<Weight, Id>& edge) {
+    if (IsFrozen()) {
+        throw std::logic_error("Cannot add an edge to a frozen graph");
+    }
+    if (edges_.size() >= std::numeric_limits<Id>::max()) {
+        throw std::length_error("Too many edges for the graph id type");
+    }
     edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
+    const EdgeId id = static_cast<EdgeId>(edges_.size() - 1);
     incidence_lists_.at(edge.from).push_back(id);
     return id;
 }
 
-template <typename Weight>
-size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+template <typename Weight, typename Id>
+size_t DirectedWeightedGraph<Weight, Id>::GetVertexCount() const {
+    return vertex_count_;
 }
 
-template <typename Weight>
-size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
-    return edges_.size();
+template <typename Weight, typename Id>
+size_t DirectedWeightedGraph<Weight, Id>::GetEdgeCount() const {
+    return IsFrozen() ? outgoing_edges_.size() : edges_.size();
 }
 
-template <typename Weight>
-const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-    return edges_.at(edge_id);
+template <typename Weight, typename Id>
+Edge<Weight, Id> DirectedWeightedGraph<Weight, Id>::GetEdge(EdgeId edge_id) const {
+    if (!IsFrozen()) {
+        return edges_.at(edge_id);
+    }
+    const EdgeLocation location = edge_locations_.at(edge_id);
+    const OutgoingEdge<Weight, Id>& edge = outgoing_edges_[location.position];
+    return {location.from, edge.to, edge.weight};
 }
 
-template <typename Weight>
-typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
-DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
+template <typename Weight, typename Id>
+typename DirectedWeightedGraph<Weight, Id>::IncidentEdgesRange
+DirectedWeightedGraph<Weight, Id>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+template <typename Weight, typename Id>
+void DirectedWeightedGraph<Weight, Id>::Freeze() {
+    if (IsFrozen()) {
+        return;
+    }
+
+    // Сортировка подсчётом по началу ребра сохраняет порядок добавления внутри вершины
+    outgoing_offsets_.assign(vertex_count_ + 1, 0);
+    for (const Edge<Weight, Id>& edge : edges_) {
+        ++outgoing_offsets_[edge.from + 1];
+    }
+    for (size_t vertex = 0; vertex < vertex_count_; ++vertex) {
+        outgoing_offsets_[vertex + 1] += outgoing_offsets_[vertex];
+    }
+
+    std::vector<size_t> positions(outgoing_offsets_.begin(), outgoing_offsets_.end() - 1);
+    outgoing_edges_.resize(edges_.size());
+    edge_locations_.resize(edges_.size());
+    for (size_t id = 0; id < edges_.size(); ++id) {
+        const Edge<Weight, Id>& edge = edges_[id];
+        const size_t position = positions[edge.from]++;
+        outgoing_edges_[position] = {static_cast<EdgeId>(id), edge.to, edge.weight};
+        edge_locations_[id] = {edge.from, static_cast<Id>(position)};
+    }
+
+    // Рёбра хранятся только в CSR, исходный список и списки смежности больше не нужны
+    edges_ = {};
+    incidence_lists_ = {};
+}
+
+template <typename Weight, typename Id>
+bool DirectedWeightedGraph<Weight, Id>::IsFrozen() const {
+    return !outgoing_offsets_.empty();
+}
+
+template <typename Weight, typename Id>
+typename DirectedWeightedGraph<Weight, Id>::OutgoingEdgesRange
+DirectedWeightedGraph<Weight, Id>::GetOutgoingEdges(VertexId vertex) const {
+    assert(IsFrozen() && vertex < vertex_count_);
+    const OutgoingEdge<Weight, Id>* edges = outgoing_edges_.data();
+    return {edges + outgoing_offsets_[vertex], edges + outgoing_offsets_[vertex + 1]};
+}
 }  // namespace graph
\ No newline at end of file
@@ -1,49 +1,243 @@
 #include "json.h"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <charconv>
 #include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define JSON_VECTOR_SCAN
+#endif
 
 namespace json {
 
 namespace {
 using namespace std::literals;
 
-Node LoadNode(std::istream& input);
-Node LoadString(std::istream& input);
+// Поиск границ пробельных участков и строк в буфере документа.
+// На x86-64 буфер просматривается блоками по 16 байт (SSE2) или по 32 байта (AVX2),
+// AVX2 выбирается во время выполнения. На прочих платформах работает посимвольный вариант
+namespace scan {
 
-std::string LoadLiteral(std::istream& input) {
-    std::string s;
-    while (std::isalpha(input.peek())) {
-        s.push_back(static_cast<char>(input.get()));
+// Пробельные символы в смысле std::isspace для локали "C"
+bool IsSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Символы, на которых прерывается участок строки, копируемый целиком
+bool IsStringSpecial(char c) {
+    return c == '"' || c == '\\' || c == '\n' || c == '\r';
+}
+
+const char* SkipSpacesScalar(const char* pos, const char* end) {
+    while (pos != end && IsSpace(*pos)) {
+        ++pos;
     }
-    return s;
+    return pos;
+}
+
+const char* FindStringSpecialScalar(const char* pos, const char* end) {
+    while (pos != end && !IsStringSpecial(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
+
+#ifdef JSON_VECTOR_SCAN
+
+// Маска пробельных байтов блока: пробел либо символ из диапазона '\t'..'\r'
+unsigned SpaceMask(__m128i block) {
+    const __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+    const __m128i is_control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted);
+    const __m128i is_space = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(is_control, is_space)));
+}
+
+unsigned StringSpecialMask(__m128i block) {
+    const __m128i quote = _mm_cmpeq_epi8(block, _mm_set1_epi8('"'));
+    const __m128i backslash = _mm_cmpeq_epi8(block, _mm_set1_epi8('\\'));
+    const __m128i line_feed = _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'));
+    const __m128i carriage_return = _mm_cmpeq_epi8(block, _mm_set1_epi8('\r'));
+    return static_cast<unsigned>(_mm_movemask_epi8(
+        _mm_or_si128(_mm_or_si128(quote, backslash), _mm_or_si128(line_feed, carriage_return))));
+}
+
+const char* SkipSpacesSse2(const char* pos, const char* end) {
+    while (end - pos >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        if (const unsigned non_space = ~SpaceMask(block) & 0xFFFFu; non_space != 0) {
+            return pos + __builtin_ctz(non_space);
+        }
+        pos += 16;
+    }
+    return SkipSpacesScalar(pos, end);
 }
 
-Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
+const char* FindStringSpecialSse2(const char* pos, const char* end) {
+    while (end - pos >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        if (const unsigned special = StringSpecialMask(block); special != 0) {
+            return pos + __builtin_ctz(special);
+        }
+        pos += 16;
+    }
+    return FindStringSpecialScalar(pos, end);
+}
+
+__attribute__((target("avx2")))
+const char* SkipSpacesAvx2(const char* pos, const char* end) {
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i control_range = _mm256_set1_epi8('\r' - '\t');
+    const __m256i space = _mm256_set1_epi8(' ');
+    while (end - pos >= 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const __m256i shifted = _mm256_sub_epi8(block, tab);
+        const __m256i is_control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, control_range), shifted);
+        const __m256i is_space = _mm256_cmpeq_epi8(block, space);
+        const unsigned non_space = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(is_control, is_space)));
+        if (non_space != 0) {
+            return pos + __builtin_ctz(non_space);
+        }
+        pos += 32;
+    }
+    return SkipSpacesSse2(pos, end);
+}
 
-    for (char c; input >> c && c != ']';) {
+__attribute__((target("avx2")))
+const char* FindStringSpecialAvx2(const char* pos, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i line_feed = _mm256_set1_epi8('\n');
+    const __m256i carriage_return = _mm256_set1_epi8('\r');
+    while (end - pos >= 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, line_feed), _mm256_cmpeq_epi8(block, carriage_return)));
+        if (const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(special)); mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+        pos += 32;
+    }
+    return FindStringSpecialSse2(pos, end);
+}
+
+#endif
+
+// Набор функций поиска, подходящий для процессора, на котором запущена программа
+struct Scanner {
+    const char* (*skip_spaces)(const char* pos, const char* end);
+    const char* (*find_string_special)(const char* pos, const char* end);
+};
+
+Scanner DetectScanner() {
+#ifdef JSON_VECTOR_SCAN
+    if (__builtin_cpu_supports("avx2")) {
+        return {SkipSpacesAvx2, FindStringSpecialAvx2};
+    }
+    return {SkipSpacesSse2, FindStringSpecialSse2};
+#else
+    return {SkipSpacesScalar, FindStringSpecialScalar};
+#endif
+}
+
+const Scanner& GetScanner() {
+    static const Scanner scanner = DetectScanner();
+    return scanner;
+}
+
+}  // namespace scan
+
+// Разбираемый документ, целиком находящийся в памяти, и текущая позиция в нём
+struct Input {
+    const char* pos;
+    const char* end;
+    // Источник памяти для массивов и словарей документа
+    std::pmr::memory_resource* resource;
+    const scan::Scanner& scanner = scan::GetScanner();
+
+    bool AtEnd() const {
+        return pos == end;
+    }
+
+    // Возвращает текущий символ или EOF, если документ закончился
+    int Peek() const {
+        return pos == end ? std::char_traits<char>::eof() : static_cast<unsigned char>(*pos);
+    }
+
+    // Пропускает пробельные символы и извлекает следующий символ, как operator>> для потока
+    bool Next(char& c) {
+        // Чаще всего пробелов перед значением нет, и до векторного поиска дело не доходит
+        if (pos != end && scan::IsSpace(*pos)) {
+            pos = scanner.skip_spaces(pos, end);
+        }
+        if (pos == end) {
+            return false;
+        }
+        c = *pos++;
+        return true;
+    }
+
+    void PutBack() {
+        --pos;
+    }
+};
+
+Node LoadNode(Input& input);
+std::string LoadString(Input& input);
+
+std::string_view LoadLiteral(Input& input) {
+    const char* begin = input.pos;
+    while (std::isalpha(input.Peek())) {
+        ++input.pos;
+    }
+    return {begin, static_cast<size_t>(input.pos - begin)};
+}
+
+Node LoadArray(Input& input) {
+    Array result(input.resource);
+
+    char c;
+    bool closed = false;
+    while (input.Next(c)) {
+        if (c == ']') {
+            closed = true;
+            break;
+        }
         if (c != ',') {
-            input.putback(c);
+            input.PutBack();
         }
         result.push_back(LoadNode(input));
     }
-    if (!input) {
+    if (!closed) {
         throw ParsingError("Array parsing error"s);
     }
     return Node(std::move(result));
 }
 
-Node LoadDict(std::istream& input) {
-    Dict dict;
+Node LoadDict(Input& input) {
+    // Пары добавляются в конец и упорядочиваются один раз после закрывающей скобки:
+    // вставка каждого ключа на своё место стоила бы O(N^2) перемещений
+    std::pmr::vector<Dict::value_type> items(input.resource);
 
-    for (char c; input >> c && c != '}';) {
+    char c;
+    bool closed = false;
+    while (input.Next(c)) {
+        if (c == '}') {
+            closed = true;
+            break;
+        }
         if (c == '"') {
-            std::string key = LoadString(input).AsString();
-            if (input >> c && c == ':') {
-                if (dict.find(key) != dict.end()) {
-                    throw ParsingError("Duplicate key '"s + key + "' have been found");
-                }
-                dict.emplace(std::move(key), LoadNode(input));
+            std::string key = LoadString(input);
+            if (input.Next(c) && c == ':') {
+                Node value = LoadNode(input);
+                items.emplace_back(std::move(key), std::move(value));
             } else {
                 throw ParsingError(": is expected but '"s + c + "' has been found"s);
             }
@@ -51,30 +245,43 @@ Node LoadDict(std::istream& input) {
             throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
         }
     }
-    if (!input) {
+    if (!closed) {
         throw ParsingError("Dictionary parsing error"s);
     }
-    return Node(std::move(dict));
+
+    auto by_key = [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+        return lhs.first < rhs.first;
+    };
+    std::sort(items.begin(), items.end(), by_key);
+    const auto duplicate = std::adjacent_find(items.begin(), items.end(),
+                                              [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+                                                  return lhs.first == rhs.first;
+                                              });
+    if (duplicate != items.end()) {
+        throw ParsingError("Duplicate key '"s + duplicate->first + "' have been found");
+    }
+    return Node(Dict(std::move(items)));
 }
 
-Node LoadString(std::istream& input) {
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
+std::string LoadString(Input& input) {
     std::string s;
     while (true) {
-        if (it == end) {
+        // Участок без кавычек, экранирования и переводов строк копируется целиком
+        const char* run_begin = input.pos;
+        input.pos = input.scanner.find_string_special(input.pos, input.end);
+        s.append(run_begin, input.pos);
+
+        if (input.AtEnd()) {
             throw ParsingError("String parsing error");
         }
-        const char ch = *it;
+        const char ch = *input.pos++;
         if (ch == '"') {
-            ++it;
             break;
         } else if (ch == '\\') {
-            ++it;
-            if (it == end) {
+            if (input.AtEnd()) {
                 throw ParsingError("String parsing error");
             }
-            const char escaped_char = *(it);
+            const char escaped_char = *input.pos++;
             switch (escaped_char) {
                 case 'n':
                     s.push_back('\n');
@@ -94,63 +301,52 @@ Node LoadString(std::istream& input) {
                 default:
                     throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
             }
-        } else if (ch == '\n' || ch == '\r') {
-            throw ParsingError("Unexpected end of line"s);
         } else {
-            s.push_back(ch);
+            throw ParsingError("Unexpected end of line"s);
         }
-        ++it;
     }
 
-    return Node(std::move(s));
+    return s;
 }
 
-Node LoadBool(std::istream& input) {
+Node LoadBool(Input& input) {
     const auto s = LoadLiteral(input);
     if (s == "true"sv) {
         return Node{true};
     } else if (s == "false"sv) {
         return Node{false};
     } else {
-        throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+        throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
     }
 }
 
-Node LoadNull(std::istream& input) {
+Node LoadNull(Input& input) {
     if (auto literal = LoadLiteral(input); literal == "null"sv) {
         return Node{nullptr};
     } else {
-        throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+        throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
     }
 }
 
-Node LoadNumber(std::istream& input) {
-    std::string parsed_num;
-
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
-        }
-    };
+Node LoadNumber(Input& input) {
+    const char* const begin = input.pos;
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
+    // Пропускает одну или более цифр
+    auto read_digits = [&input] {
+        if (!std::isdigit(input.Peek())) {
             throw ParsingError("A digit is expected"s);
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        while (std::isdigit(input.Peek())) {
+            ++input.pos;
         }
     };
 
-    if (input.peek() == '-') {
-        read_char();
+    if (input.Peek() == '-') {
+        ++input.pos;
     }
     // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
+    if (input.Peek() == '0') {
+        ++input.pos;
         // После 0 в JSON не могут идти другие цифры
     } else {
         read_digits();
@@ -158,41 +354,41 @@ Node LoadNumber(std::istream& input) {
 
     bool is_int = true;
     // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
+    if (input.Peek() == '.') {
+        ++input.pos;
         read_digits();
         is_int = false;
     }
 
     // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    if (int ch = input.Peek(); ch == 'e' || ch == 'E') {
+        ++input.pos;
+        if (ch = input.Peek(); ch == '+' || ch == '-') {
+            ++input.pos;
         }
         read_digits();
         is_int = false;
     }
 
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении
-                // код ниже попробует преобразовать строку в double
-            }
+    const char* const end = input.pos;
+    if (is_int) {
+        // Сначала пробуем преобразовать строку в int. При переполнении
+        // код ниже преобразует её в double
+        int value;
+        if (const auto [ptr, ec] = std::from_chars(begin, end, value); ec == std::errc{} && ptr == end) {
+            return value;
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
     }
+    double value;
+    if (const auto [ptr, ec] = std::from_chars(begin, end, value); ec == std::errc{} && ptr == end) {
+        return value;
+    }
+    throw ParsingError("Failed to convert "s + std::string(begin, end) + " to number"s);
 }
 
-Node LoadNode(std::istream& input) {
+Node LoadNode(Input& input) {
     char c;
-    if (!(input >> c)) {
+    if (!input.Next(c)) {
         throw ParsingError("Unexpected EOF"s);
     }
     switch (c) {
@@ -211,30 +407,101 @@ Node LoadNode(std::istream& input) {
             // литералов true либо false
             [[fallthrough]];
         case 'f':
-            input.putback(c);
+            input.PutBack();
             return LoadBool(input);
         case 'n':
-            input.putback(c);
+            input.PutBack();
             return LoadNull(input);
         default:
-            input.putback(c);
+            input.PutBack();
             return LoadNumber(input);
     }
 }
 
+// Буфер вывода. Значения форматируются в строку, которая сбрасывается в поток крупными блоками.
+// Строка переиспользуется между вызовами Print в пределах потока выполнения
+class Writer {
+public:
+    explicit Writer(std::ostream& out)
+        : out_(out)
+        , buffer_(Buffer()) {
+        buffer_.clear();
+    }
+
+    void Put(char c) {
+        buffer_.push_back(c);
+    }
+
+    void Write(std::string_view text) {
+        buffer_.append(text);
+        FlushIfFull();
+    }
+
+    void WriteSpaces(int count) {
+        buffer_.append(static_cast<size_t>(count), ' ');
+    }
+
+    template <typename Number>
+    void WriteNumber(Number value) {
+        std::array<char, 32> chars;
+        std::to_chars_result result;
+        if constexpr (std::is_floating_point_v<Number>) {
+            // Та же запись, что у operator<< с точностью потока по умолчанию
+            result = std::to_chars(chars.data(), chars.data() + chars.size(), value, std::chars_format::general, 6);
+        } else {
+            result = std::to_chars(chars.data(), chars.data() + chars.size(), value);
+        }
+        buffer_.append(chars.data(), result.ptr);
+        FlushIfFull();
+    }
+
+    void Flush() {
+        out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+
+private:
+    static constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+    static std::string& Buffer() {
+        thread_local std::string buffer = [] {
+            std::string buffer;
+            buffer.reserve(FLUSH_SIZE * 2);
+            return buffer;
+        }();
+        return buffer;
+    }
+
+    void FlushIfFull() {
+        if (buffer_.size() >= FLUSH_SIZE) {
+            Flush();
+        }
+    }
+
+    std::ostream& out_;
+    std::string& buffer_;
+};
+
 struct PrintContext {
-    std::ostream& out;
+    Writer& out;
+    Format format = Format::Pretty;
     int indent_step = 4;
     int indent = 0;
 
-    void PrintIndent() const {
-        for (int i = 0; i < indent; ++i) {
-            out.put(' ');
+    bool IsCompact() const {
+        return format == Format::Compact;
+    }
+
+    // Переходит на новую строку с текущим отступом. В компактном режиме ничего не выводит
+    void PrintLineBreak() const {
+        if (!IsCompact()) {
+            out.Put('\n');
+            out.WriteSpaces(indent);
         }
     }
 
     PrintContext Indented() const {
-        return {out, indent_step, indent_step + indent};
+        return {out, format, indent_step, indent_step + indent};
     }
 };
 
@@ -242,31 +509,38 @@ void PrintNode(const Node& value, const PrintContext& ctx);
 
 template <typename Value>
 void PrintValue(const Value& value, const PrintContext& ctx) {
-    ctx.out << value;
+    ctx.out.WriteNumber(value);
 }
 
-void PrintString(const std::string& value, std::ostream& out) {
-    out.put('"');
-    for (const char c : value) {
-        switch (c) {
+void PrintString(const std::string& value, Writer& out) {
+    const scan::Scanner& scanner = scan::GetScanner();
+    const char* pos = value.data();
+    const char* const end = pos + value.size();
+
+    out.Put('"');
+    while (true) {
+        // Участок без символов, требующих экранирования, копируется целиком
+        const char* run_end = scanner.find_string_special(pos, end);
+        out.Write({pos, static_cast<size_t>(run_end - pos)});
+        if (run_end == end) {
+            break;
+        }
+        switch (*run_end) {
             case '\r':
-                out << "\\r"sv;
+                out.Write("\\r"sv);
                 break;
             case '\n':
-                out << "\\n"sv;
+                out.Write("\\n"sv);
                 break;
-            case '"':
-                // Символы " и \ выводятся как \" или \\, соответственно
-                [[fallthrough]];
-            case '\\':
-                out.put('\\');
-                [[fallthrough]];
             default:
-                out.put(c);
+                // Символы " и \ выводятся как \" или \\, соответственно
+                out.Put('\\');
+                out.Put(*run_end);
                 break;
         }
+        pos = run_end + 1;
     }
-    out.put('"');
+    out.Put('"');
 }
 
 template <>
@@ -276,7 +550,7 @@ void PrintValue<std::string>(const std::string& value, const PrintContext& ctx)
 
 template <>
 void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
-    ctx.out << "null"sv;
+    ctx.out.Write("null"sv);
 }
 
 // В специализаци шаблона PrintValue для типа bool параметр value передаётся
@@ -285,49 +559,55 @@ void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx)
 // void PrintValue(bool value, const PrintContext& ctx);
 template <>
 void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
-    ctx.out << (value ? "true"sv : "false"sv);
+    ctx.out.Write(value ? "true"sv : "false"sv);
 }
 
 template <>
 void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
-    std::ostream& out = ctx.out;
-    out << "[\n"sv;
+    Writer& out = ctx.out;
+    out.Put('[');
+    if (nodes.empty() && !ctx.IsCompact()) {
+        // Пустой контейнер в развёрнутом виде занимает отдельную пустую строку
+        out.Put('\n');
+    }
     bool first = true;
     auto inner_ctx = ctx.Indented();
     for (const Node& node : nodes) {
         if (first) {
             first = false;
         } else {
-            out << ",\n"sv;
+            out.Put(',');
         }
-        inner_ctx.PrintIndent();
+        inner_ctx.PrintLineBreak();
         PrintNode(node, inner_ctx);
     }
-    out.put('\n');
-    ctx.PrintIndent();
-    out.put(']');
+    ctx.PrintLineBreak();
+    out.Put(']');
 }
 
 template <>
 void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
-    std::ostream& out = ctx.out;
-    out << "{\n"sv;
+    Writer& out = ctx.out;
+    out.Put('{');
+    if (nodes.empty() && !ctx.IsCompact()) {
+        // Пустой контейнер в развёрнутом виде занимает отдельную пустую строку
+        out.Put('\n');
+    }
     bool first = true;
     auto inner_ctx = ctx.Indented();
     for (const auto& [key, node] : nodes) {
         if (first) {
             first = false;
         } else {
-            out << ",\n"sv;
+            out.Put(',');
         }
-        inner_ctx.PrintIndent();
+        inner_ctx.PrintLineBreak();
         PrintString(key, ctx.out);
-        out << ": "sv;
+        out.Write(ctx.IsCompact() ? ":"sv : ": "sv);
         PrintNode(node, inner_ctx);
     }
-    out.put('\n');
-    ctx.PrintIndent();
-    out.put('}');
+    ctx.PrintLineBreak();
+    out.Put('}');
 }
 
 void PrintNode(const Node& node, const PrintContext& ctx) {
@@ -340,12 +620,91 @@ void PrintNode(const Node& node, const PrintContext& ctx) {
 
 }  // namespace
 
-Document Load(std::istream& input) {
-    return Document{LoadNode(input)};
+Dict::Dict(std::pmr::vector<value_type> sorted_items)
+    : items_(std::move(sorted_items)) {
+    assert(std::adjacent_find(items_.begin(), items_.end(),
+                              [](const value_type& lhs, const value_type& rhs) {
+                                  return !(lhs.first < rhs.first);
+                              }) == items_.end());
+}
+
+Dict::const_iterator Dict::LowerBound(std::string_view key) const {
+    return std::lower_bound(items_.begin(), items_.end(), key,
+                            [](const value_type& item, std::string_view key) {
+                                return item.first < key;
+                            });
+}
+
+Dict::const_iterator Dict::find(std::string_view key) const {
+    const auto it = LowerBound(key);
+    return it != items_.end() && it->first == key ? it : items_.end();
+}
+
+Dict::iterator Dict::find(std::string_view key) {
+    return items_.begin() + (std::as_const(*this).find(key) - items_.cbegin());
+}
+
+size_t Dict::count(std::string_view key) const {
+    return find(key) != items_.end() ? 1 : 0;
+}
+
+const Node& Dict::at(std::string_view key) const {
+    const auto it = find(key);
+    if (it == items_.end()) {
+        throw std::out_of_range("Dict: key '"s + std::string(key) + "' not found"s);
+    }
+    return it->second;
+}
+
+Node& Dict::at(std::string_view key) {
+    return const_cast<Node&>(std::as_const(*this).at(key));
+}
+
+Node& Dict::operator[](std::string_view key) {
+    return emplace(std::string(key), Node{}).first->second;
+}
+
+std::pair<Dict::iterator, bool> Dict::emplace(std::string key, Node value) {
+    const auto position = items_.begin() + (LowerBound(key) - items_.cbegin());
+    if (position != items_.end() && position->first == key) {
+        return {position, false};
+    }
+    return {items_.emplace(position, std::move(key), std::move(value)), true};
+}
+
+bool Dict::operator==(const Dict& rhs) const {
+    return items_ == rhs.items_;
+}
+
+Document Load(std::string_view input, Allocation allocation) {
+    if (allocation == Allocation::Heap) {
+        Input in{input.data(), input.data() + input.size(), std::pmr::get_default_resource()};
+        return Document{LoadNode(in)};
+    }
+
+    // Первый блок арены соразмерен тексту документа, чтобы обойтись без частых дозапросов памяти.
+    // Освобождение отдельных узлов в арене ничего не стоит, а вся память возвращается одним вызовом
+    auto arena = std::make_unique<std::pmr::monotonic_buffer_resource>(std::max<size_t>(input.size(), 1024));
+    Input in{input.data(), input.data() + input.size(), arena.get()};
+    Node root = LoadNode(in);
+    return Document{std::move(root), std::move(arena)};
+}
+
+Document Load(std::istream& input, Allocation allocation) {
+    // Документ считывается целиком, после чего разбирается прямо в памяти
+    std::string buffer;
+    std::array<char, 64 * 1024> chunk;
+    while (input) {
+        input.read(chunk.data(), chunk.size());
+        buffer.append(chunk.data(), static_cast<size_t>(input.gcount()));
+    }
+    return Load(buffer, allocation);
 }
 
-void Print(const Document& doc, std::ostream& output) {
-    PrintNode(doc.GetRoot(), PrintContext{output});
+void Print(const Document& doc, std::ostream& output, Format format) {
+    Writer writer(output);
+    PrintNode(doc.GetRoot(), PrintContext{writer, format});
+    writer.Flush();
 }
 
 }  // namespace json
@@ -1,16 +1,86 @@
 #pragma once
 
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
-using Array = std::vector<Node>;
+using Array = std::pmr::vector<Node>;
+
+// Словарь JSON-объекта: упорядоченный по ключам вектор пар ключ-значение.
+// Объекты в запросах содержат единицы ключей, поэтому непрерывное хранение
+// обходится дешевле дерева: одно выделение памяти на словарь вместо одного на ключ.
+// Короткие ключи хранятся в std::string без выделения памяти.
+// Порядок обхода и вывода совпадает с порядком std::map
+class Dict {
+public:
+    using value_type = std::pair<std::string, Node>;
+    using iterator = std::pmr::vector<value_type>::iterator;
+    using const_iterator = std::pmr::vector<value_type>::const_iterator;
+
+    Dict() = default;
+    // Словарь, размещающий свои элементы в resource
+    explicit Dict(std::pmr::memory_resource* resource)
+        : items_(resource) {
+    }
+    // Словарь из пар, уже упорядоченных по ключу и без повторяющихся ключей
+    explicit Dict(std::pmr::vector<value_type> sorted_items);
+
+    const Node& at(std::string_view key) const;
+    Node& at(std::string_view key);
+
+    const_iterator find(std::string_view key) const;
+    iterator find(std::string_view key);
+    size_t count(std::string_view key) const;
+
+    // Возвращает значение по ключу, добавляя пустое значение при его отсутствии
+    Node& operator[](std::string_view key);
+    // Добавляет пару, если ключа ещё нет. Возвращает итератор на элемент с ключом и признак вставки
+    std::pair<iterator, bool> emplace(std::string key, Node value);
+
+    const_iterator begin() const {
+        return items_.begin();
+    }
+    const_iterator end() const {
+        return items_.end();
+    }
+    iterator begin() {
+        return items_.begin();
+    }
+    iterator end() {
+        return items_.end();
+    }
+
+    size_t size() const {
+        return items_.size();
+    }
+    bool empty() const {
+        return items_.empty();
+    }
+    void reserve(size_t size) {
+        items_.reserve(size);
+    }
+
+    bool operator==(const Dict& rhs) const;
+
+    // Источник памяти элементов: арена документа или память по умолчанию
+    std::pmr::memory_resource* resource() const {
+        return items_.get_allocator().resource();
+    }
+
+private:
+    const_iterator LowerBound(std::string_view key) const;
+
+    std::pmr::vector<value_type> items_;
+};
 
 class ParsingError : public std::runtime_error {
 public:
@@ -68,7 +138,7 @@ public:
         return std::holds_alternative<Array>(*this);
     }
 
-    const Array& AsArray() const {
+    const Array& AsArray() const& {
         using namespace std::literals;
         if (!IsArray()) {
             throw std::logic_error("Not an array"s);
@@ -77,7 +147,7 @@ public:
         return std::get<Array>(*this);
     }
 
-    Array& AsArray() {
+    Array& AsArray() & {
         using namespace std::literals;
         if (!IsArray()) {
             throw std::logic_error("Not an array"s);
@@ -86,10 +156,20 @@ public:
         return std::get<Array>(*this);
     }
 
+    // Позволяет забрать содержимое временного узла без копирования.
+    // Массив из арены документа копируется в память по умолчанию, чтобы пережить документ
+    Array AsArray() && {
+        Array& array = AsArray();
+        if (array.get_allocator().resource() != std::pmr::get_default_resource()) {
+            return Array(array, std::pmr::get_default_resource());
+        }
+        return std::move(array);
+    }
+
     bool IsString() const {
         return std::holds_alternative<std::string>(*this);
     }
-    const std::string& AsString() const {
+    const std::string& AsString() const& {
         using namespace std::literals;
         if (!IsString()) {
             throw std::logic_error("Not a string"s);
@@ -98,11 +178,20 @@ public:
         return std::get<std::string>(*this);
     }
 
+    std::string&& AsString() && {
+        using namespace std::literals;
+        if (!IsString()) {
+            throw std::logic_error("Not a string"s);
+        }
+
+        return std::get<std::string>(std::move(*this));
+    }
+
     bool IsDict() const {
         return std::holds_alternative<Dict>(*this);
     }
 
-    const Dict& AsDict() const {
+    const Dict& AsDict() const& {
         using namespace std::literals;
         if (!IsDict()) {
             throw std::logic_error("Not a dict"s);
@@ -111,7 +200,7 @@ public:
         return std::get<Dict>(*this);
     }
 
-    Dict& AsDict() {
+    Dict& AsDict() & {
         using namespace std::literals;
         if (!IsDict()) {
             throw std::logic_error("Not a dict"s);
@@ -120,6 +209,16 @@ public:
         return std::get<Dict>(*this);
     }
 
+    // Позволяет забрать содержимое временного узла без копирования.
+    // Словарь из арены документа копируется в память по умолчанию, чтобы пережить документ
+    Dict AsDict() && {
+        Dict& dict = AsDict();
+        if (dict.resource() != std::pmr::get_default_resource()) {
+            return Dict(static_cast<const Dict&>(dict));
+        }
+        return std::move(dict);
+    }
+
     bool operator==(const Node& rhs) const {
         return GetValue() == rhs.GetValue();
     }
@@ -143,11 +242,20 @@ public:
         : root_(std::move(root)) {
     }
 
+    // Документ, массивы и словари которого размещены в arena.
+    // Арена освобождается целиком вместе с документом
+    Document(Node root, std::unique_ptr<std::pmr::memory_resource> arena)
+        : arena_(std::move(arena))
+        , root_(std::move(root)) {
+    }
+
     const Node& GetRoot() const {
         return root_;
     }
 
 private:
+    // Объявлена раньше корня, чтобы пережить его узлы
+    std::unique_ptr<std::pmr::memory_resource> arena_;
     Node root_;
 };
 
@@ -159,8 +267,23 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
     return !(lhs == rhs);
 }
 
-Document Load(std::istream& input);
+// Способ размещения в памяти массивов и словарей разбираемого документа
+enum class Allocation {
+    Heap,   // каждый массив и словарь выделяет и освобождает память самостоятельно
+    Arena,  // все массивы и словари размещаются в арене, принадлежащей документу
+};
+
+// Считывает поток целиком и разбирает его содержимое
+Document Load(std::istream& input, Allocation allocation = Allocation::Heap);
+// Разбирает документ, находящийся в памяти
+Document Load(std::string_view input, Allocation allocation = Allocation::Heap);
+
+// Оформление выводимого документа
+enum class Format {
+    Pretty,   // каждый элемент на отдельной строке с отступом в 4 пробела
+    Compact,  // без пробелов и переводов строк
+};
 
-void Print(const Document& doc, std::ostream& output);
+void Print(const Document& doc, std::ostream& output, Format format = Format::Pretty);
 
 }  // namespace json
@@ -1,5 +1,6 @@
 #include "json_builder.h"
 #include <string>
+#include <utility>
 
 json::Builder::Builder()
 {
@@ -14,8 +15,9 @@ json::Builder &json::Builder::Key(const std::string& key)
 
     Node *node = nodes_stack_.back();
     if (node->IsDict()) {
-        node->AsDict()[key] = Node();
-        nodes_stack_.push_back(&node->AsDict().at(key));
+        Node &value = node->AsDict()[key];
+        value = Node();
+        nodes_stack_.push_back(&value);
     } else {
         throw std::logic_error("key insertion failed - invalid node type - not dict");
     }
@@ -29,11 +31,11 @@ json::Builder &json::Builder::Value(Node::Value value)
 
     Node *node = nodes_stack_.back();
     if (node->IsNull()) {
-        node->GetValue() = value;
+        node->GetValue() = std::move(value);
         nodes_stack_.pop_back();
     } else if (node->IsArray()) {
         Node n;
-        n.GetValue() = value;
+        n.GetValue() = std::move(value);
         node->AsArray().emplace_back(std::move(n));
     } else {
         throw std::logic_error("value insertion failed - invalid node type - not null|array");
@@ -41,24 +43,22 @@ json::Builder &json::Builder::Value(Node::Value value)
     return *this;
 }
 
-json::Builder::DictItemContext &json::Builder::StartDict()
+json::Builder::DictItemContext json::Builder::StartDict()
 {
     if (nodes_stack_.empty())
         throw std::logic_error("start dict failed - invalid node");
 
     StartContainer(nodes_stack_.back(), Dict());
-    static DictItemContext context = DictItemContext(*this);
-    return context;
+    return DictItemContext(*this);
 }
 
-json::Builder::ArrayItemContext &json::Builder::StartArray()
+json::Builder::ArrayItemContext json::Builder::StartArray()
 {
     if (nodes_stack_.empty())
         throw std::logic_error("start array failed - invalid node");
 
     StartContainer(nodes_stack_.back(), Array());
-    static ArrayItemContext context = ArrayItemContext(*this);
-    return context;
+    return ArrayItemContext(*this);
 }
 
 json::Builder &json::Builder::EndDict()
@@ -90,17 +90,16 @@ json::Node json::Builder::Build()
     if (!nodes_stack_.empty())
         throw std::logic_error("build node error - uncomplited node");
 
-    return root_node_;
+    return std::move(root_node_);
 }
 
 json::Builder::DictItemContext::DictItemContext(Builder &b) : builder{b} {
 }
 
-json::Builder::DictValueContext &json::Builder::DictItemContext::Key(const std::string &key)
+json::Builder::DictValueContext json::Builder::DictItemContext::Key(const std::string &key)
 {
     builder.Key(key);
-    static DictValueContext context = DictValueContext(builder);
-    return context;
+    return DictValueContext(builder);
 }
 
 json::Builder &json::Builder::DictItemContext::EndDict()
@@ -111,19 +110,18 @@ json::Builder &json::Builder::DictItemContext::EndDict()
 json::Builder::ArrayItemContext::ArrayItemContext(Builder &b) : builder{b} {
 }
 
-json::Builder::ArrayItemContext &json::Builder::ArrayItemContext::Value(Node::Value value)
+json::Builder::ArrayItemContext json::Builder::ArrayItemContext::Value(Node::Value value)
 {
-    builder.Value(value);
-    static ArrayItemContext context = ArrayItemContext(builder);
-    return context;
+    builder.Value(std::move(value));
+    return ArrayItemContext(builder);
 }
 
-json::Builder::DictItemContext &json::Builder::ArrayItemContext::StartDict()
+json::Builder::DictItemContext json::Builder::ArrayItemContext::StartDict()
 {
     return builder.StartDict();
 }
 
-json::Builder::ArrayItemContext &json::Builder::ArrayItemContext::StartArray()
+json::Builder::ArrayItemContext json::Builder::ArrayItemContext::StartArray()
 {
     return builder.StartArray();
 }
@@ -136,23 +134,20 @@ json::Builder &json::Builder::ArrayItemContext::EndArray()
 json::Builder::DictValueContext::DictValueContext(Builder &b) : builder{b} {
 }
 
-json::Builder::DictItemContext &json::Builder::DictValueContext::Value(Node::Value value)
+json::Builder::DictItemContext json::Builder::DictValueContext::Value(Node::Value value)
 {
-    builder.Value(value);
-    static DictItemContext context = DictItemContext(builder);
-    return context;
+    builder.Value(std::move(value));
+    return DictItemContext(builder);
 }
 
-json::Builder::DictItemContext &json::Builder::DictValueContext::StartDict()
+json::Builder::DictItemContext json::Builder::DictValueContext::StartDict()
 {
     builder.StartDict();
-    static DictItemContext context = DictItemContext(builder);
-    return context;
+    return DictItemContext(builder);
 }
 
-json::Builder::ArrayItemContext &json::Builder::DictValueContext::StartArray()
+json::Builder::ArrayItemContext json::Builder::DictValueContext::StartArray()
 {
     builder.StartArray();
-    static ArrayItemContext context = ArrayItemContext(builder);
-    return context;
+    return ArrayItemContext(builder);
 }
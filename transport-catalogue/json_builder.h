@@ -22,18 +22,20 @@ public:
     Builder();
     Builder& Key(const std::string& key);   // Задаёт строковое значение ключа для очередной пары ключ-значение. Следующий вызов метода обязательно должен задавать соответствующее этому ключу значение с помощью метода Value или начинать его определение с помощью StartDict или StartArray.
     Builder& Value(Node::Value);            // Задаёт значение, соответствующее ключу при определении словаря, очередной элемент массива или, если вызвать сразу после конструктора json::Builder, всё содержимое конструируемого JSON-объекта. Может принимать как простой объект — число или строку — так и целый массив или словарь. Здесь Node::Value — это синоним для базового класса Node, шаблона variant с набором возможных типов-значений. Смотрите заготовку кода.
-    DictItemContext& StartDict();           // Начинает определение сложного значения-словаря. Вызывается в тех же контекстах, что и Value. Следующим вызовом обязательно должен быть Key или EndDict.
-    ArrayItemContext& StartArray();         // Начинает определение сложного значения-массива. Вызывается в тех же контекстах, что и Value. Следующим вызовом обязательно должен быть EndArray или любой, задающий новое значение: Value, StartDict или StartArray.
+    DictItemContext StartDict();            // Начинает определение сложного значения-словаря. Вызывается в тех же контекстах, что и Value. Следующим вызовом обязательно должен быть Key или EndDict.
+    ArrayItemContext StartArray();          // Начинает определение сложного значения-массива. Вызывается в тех же контекстах, что и Value. Следующим вызовом обязательно должен быть EndArray или любой, задающий новое значение: Value, StartDict или StartArray.
     Builder& EndDict();                     // Завершает определение сложного значения-словаря. Последним незавершённым вызовом Start* должен быть StartDict.
     Builder& EndArray();                    // Завершает определение сложного значения-массива. Последним незавершённым вызовом Start* должен быть StartArray.
-    Node Build();                           // Возвращает объект json::Node, содержащий JSON, описанный предыдущими вызовами методов. К этому моменту для каждого Start* должен быть вызван соответствующий End*. При этом сам объект должен быть определён, то есть вызов json::Builder{}.Build() недопустим.
+    Node Build();                           // Возвращает объект json::Node, содержащий JSON, описанный предыдущими вызовами методов. К этому моменту для каждого Start* должен быть вызван соответствующий End*. При этом сам объект должен быть определён, то есть вызов json::Builder{}.Build() недопустим. Построенный узел перемещается из строителя, поэтому повторный вызов вернёт пустой узел.
 
+    // Контексты хранят только ссылку на свой строитель и возвращаются по значению,
+    // поэтому независимые строители можно использовать одновременно из разных потоков
     class DictItemContext{
         Builder &builder;
 
     public:
         DictItemContext(Builder &);
-        DictValueContext& Key(const std::string& key);
+        DictValueContext Key(const std::string& key);
         Builder& EndDict();
     };
 
@@ -42,9 +44,9 @@ public:
 
     public:
         ArrayItemContext(Builder &);
-        ArrayItemContext& Value(Node::Value);
-        DictItemContext& StartDict();
-        ArrayItemContext& StartArray();
+        ArrayItemContext Value(Node::Value);
+        DictItemContext StartDict();
+        ArrayItemContext StartArray();
         Builder& EndArray();
     };
 
@@ -53,9 +55,9 @@ public:
 
     public:
         DictValueContext(Builder &);
-        DictItemContext& Value(Node::Value);
-        DictItemContext& StartDict();
-        ArrayItemContext& StartArray();
+        DictItemContext Value(Node::Value);
+        DictItemContext StartDict();
+        ArrayItemContext StartArray();
     };
 };
 
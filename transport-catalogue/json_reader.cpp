@@ -1,6 +1,9 @@
 #include "json_reader.h"
 #include "json_builder.h"
+#include "compression.h"
 
+#include <algorithm>
+#include <optional>
 #include <sstream>
 
 /*
@@ -12,13 +15,9 @@ JsonReader::JsonReader(RequestHandler &handler)
     : handler{handler} {
 }
 
-json::Dict JsonReader::ParseRequest(std::istream &input)
+json::Document JsonReader::ParseRequest(std::istream &input)
 {
-    using namespace json;
-    Document doc = json::Load(input);
-    const json::Node &node = doc.GetRoot();
-
-    return node.AsDict();
+    return json::Load(input, json::Allocation::Arena);
 }
 
 
@@ -43,37 +42,38 @@ svg::Color RenderColor(const json::Node &node)
 void JsonReader::BaseRequestHandler(const json::Node &node)
 {
     using namespace json;
-    std::deque<Node> bus_nodes;
-    std::deque<Node> stop_nodes;
+    // Запросы не копируются: достаточно ссылок на словари разобранного документа
+    std::vector<const Dict*> bus_requests;
+    std::vector<const Dict*> stop_requests;
 
     for (const Node &node : node.AsArray()) {
         auto &dict = node.AsDict();
         if (dict.at("type").AsString() == "Bus") {
-            bus_nodes.push_back(dict);
+            bus_requests.push_back(&dict);
         } else if (dict.at("type").AsString() == "Stop") {
-            stop_nodes.push_back(dict);
+            stop_requests.push_back(&dict);
         } else {
             throw std::invalid_argument("JsonReader: invalid request type");
         }
     }
 
-    for (const Node &stop_node : stop_nodes){
-        const auto &stop = stop_node.AsDict();
+    for (const Dict *stop_request : stop_requests){
+        const auto &stop = *stop_request;
         handler.AddStop(stop.at("name").AsString(),
                         stop.at("latitude").AsDouble(),
                         stop.at("longitude").AsDouble());
     }
 
-    for (const Node &stop_node : stop_nodes){
-        const auto &stop = stop_node.AsDict();
+    for (const Dict *stop_request : stop_requests){
+        const auto &stop = *stop_request;
         const auto &from_stop = stop.at("name").AsString();
         for (const auto &[to_stop, distance_node] : stop.at("road_distances").AsDict()) {
             handler.AddDistanceBetweenStops(from_stop, to_stop, distance_node.AsDouble());
         }
     }
 
-    for (const Node &bus_node : bus_nodes){
-        const auto &bus = bus_node.AsDict();
+    for (const Dict *bus_request : bus_requests){
+        const auto &bus = *bus_request;
 
         const auto &stops_node = bus.at("stops").AsArray();
         std::vector<std::string> stops(stops_node.size());
@@ -98,23 +98,72 @@ void JsonReader::StatRequestHandler(const json::Node &node, std::ostream &stream
     builder.StartArray();
 
     for (const Node &node : nodes){
-        auto &dict = node.AsDict();
+        builder.Value(StatRequest(node.AsDict()).AsDict());
+    }
+    builder.EndArray();
+    Print(Document(builder.Build()), stream, output_format);
+}
 
-        const std::string type = dict.at("type").AsString();
-        if (type == "Bus") {
-            builder.Value(StatRequestBus(dict).AsDict());
-        } else if (type == "Stop") {
-            builder.Value(StatRequestStop(dict).AsDict());
-        } else if (type == "Map") {
-            builder.Value(StatRequestMap(dict).AsDict());
-        } else if (type == "Route") {
-            builder.Value(StatRequestRoute(dict).AsDict());
-        } else {
-            throw std::invalid_argument("JsonReader: invalid request type");
+void JsonReader::StatRequestStream(std::istream &input, std::ostream &stream)
+{
+    using namespace json;
+
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
         }
+        // Ответ выводится одной строкой сразу после разбора запроса
+        StatRequestLine(line, stream);
+        stream << '\n';
+        stream.flush();
+    }
+}
+
+void JsonReader::StatRequestLine(std::string_view request, std::ostream &stream)
+{
+    using namespace json;
+
+    // Ошибка в одном запросе не прерывает обработку следующих
+    std::optional<int> request_id;
+    Node response;
+    try {
+        const Document document = Load(request);
+        const Dict &dict = document.GetRoot().AsDict();
+        if (const auto id = dict.find("id"); id != dict.end() && id->second.IsInt()) {
+            request_id = id->second.AsInt();
+        }
+        response = StatRequest(dict);
+    } catch (const std::exception &e) {
+        Builder builder;
+        builder.StartDict();
+        if (request_id) {
+            builder.Key("request_id").Value(*request_id);
+        }
+        builder.Key("error_message").Value(std::string(e.what()));
+        response = builder.EndDict().Build();
+    }
+    Print(Document(std::move(response)), stream, Format::Compact);
+}
+
+Node JsonReader::StatRequest(const json::Dict &dict)
+{
+    const std::string &type = dict.at("type").AsString();
+    if (type == "Bus") {
+        return StatRequestBus(dict);
+    } else if (type == "Stop") {
+        return StatRequestStop(dict);
+    } else if (type == "Map") {
+        return StatRequestMap(dict);
+    } else if (type == "Route") {
+        return StatRequestRoute(dict);
+    } else if (type == "NearestStops") {
+        return StatRequestNearestStops(dict);
+    } else if (type == "StopsInRadius") {
+        return StatRequestStopsInRadius(dict);
+    } else {
+        throw std::invalid_argument("JsonReader: invalid request type");
     }
-    builder.EndArray();
-    Print(Document(builder.Build()), stream);
 }
 
 void JsonReader::RenderSettingsRequestHandler(const json::Node &node)
@@ -153,7 +202,11 @@ void JsonReader::RoutingSettingsHandler(const json::Node &node)
     double bus_wait_time = nodes.at("bus_wait_time").AsInt();
     double bus_velocity = nodes.at("bus_velocity").AsInt();
 
-    handler.SetRouterSettings(bus_wait_time, bus_velocity);
+    // Переходы пешком необязательны
+    double walk_radius = nodes.count("walk_radius") ? nodes.at("walk_radius").AsDouble() : 0;
+    double walking_velocity = nodes.count("walking_velocity") ? nodes.at("walking_velocity").AsDouble() : 0;
+
+    handler.SetRouterSettings(bus_wait_time, bus_velocity, walk_radius, walking_velocity);
 }
 
 Node JsonReader::StatRequestBus(const json::Dict &dict)
@@ -195,7 +248,7 @@ Node JsonReader::StatRequestStop(const json::Dict &dict)
         std::transform(buses.begin(), buses.end(),
                        buses_array.begin(),
                        [](const auto &value){ return Node{value}; });
-        builder.Key("buses").Value(buses_array);
+        builder.Key("buses").Value(std::move(buses_array));
     }
 
     builder.EndDict();
@@ -210,53 +263,177 @@ Node JsonReader::StatRequestMap(const json::Dict &dict)
     builder.StartDict();
     builder.Key("request_id").Value(dict.at("id").AsInt());
 
-    std::ostringstream ostream;
-    handler.RenderMap(ostream);
-    builder.Key("map").Value(ostream.str());
+    // По запросу карта сжимается по мере вывода и возвращается в кодировке base64
+    // Неизвестный формат сжатия - ошибка только этого запроса
+    if (const auto compression = dict.find("compression"); compression != dict.end()) {
+        const auto format = compression::ParseFormat(compression->second.AsString());
+        if (!format) {
+            builder.Key("error_message").Value("unknown compression");
+            builder.EndDict();
+            return builder.Build();
+        }
+        std::string map;
+        compression::CompressedStream ostream(*format, map);
+        handler.RenderMap(ostream);
+        ostream.Finish();
+        builder.Key("map").Value(std::move(map));
+    } else {
+        std::ostringstream ostream;
+        handler.RenderMap(ostream);
+        builder.Key("map").Value(ostream.str());
+    }
 
     builder.EndDict();
     return builder.Build();
 }
 
+// Элемент маршрута в ответе на запрос Route
+struct RouteItemBuilder{
+    json::Dict operator()(const RouteInfo::StopInfo& info) const {
+        json::Dict dict;
+        dict["stop_name"]   = std::string(info.name);
+        dict["time"]        = info.time;
+        dict["type"]        = "Wait";
+        return dict;
+    }
+    json::Dict operator()(const RouteInfo::BusInfo& info) const {
+        json::Dict dict;
+        dict["bus"]         = std::string(info.name);
+        dict["span_count"]  = static_cast<int>(info.span_count);
+        dict["time"]        = info.time;
+        dict["type"]        = "Bus";
+        return dict;
+    }
+    json::Dict operator()(const RouteInfo::WalkInfo& info) const {
+        json::Dict dict;
+        dict["from"]        = std::string(info.from);
+        dict["time"]        = info.time;
+        dict["to"]          = std::string(info.to);
+        dict["type"]        = "Walk";
+        return dict;
+    }
+};
+
+// Элементы маршрута в порядке следования
+static json::Array RouteItems(const RouteInfo& route)
+{
+    json::Array array;
+    for (const RouteInfo::Item& item : route.items){
+        array.push_back(std::visit(RouteItemBuilder{}, item));
+    }
+    return array;
+}
+
 Node JsonReader::StatRequestRoute(const json::Dict &dict)
 {
     using namespace json;
 
+    const std::string& from_stop = dict.at("from").AsString();
+    const std::string& to_stop = dict.at("to").AsString();
+
+    if (dict.count("pareto") && dict.at("pareto").AsBool()){
+        return StatRequestParetoRoute(dict, from_stop, to_stop);
+    }
+
     Builder builder;
     builder.StartDict();
     builder.Key("request_id").Value(dict.at("id").AsInt());
 
-    const std::string& from_stop = dict.at("from").AsString();
-    const std::string& to_stop = dict.at("to").AsString();
-
     const auto &info = handler.MakeRoute(from_stop, to_stop);
     if (info == std::nullopt){
         builder.Key("error_message").Value("not found");
+    } else{
+        builder.Key("items").Value(RouteItems(*info));
+        builder.Key("total_time").Value(info->total_time);
+    }
+
+    builder.EndDict();
+    return builder.Build();
+}
+
+Node JsonReader::StatRequestParetoRoute(const json::Dict &dict, const std::string &from_stop, const std::string &to_stop)
+{
+    using namespace json;
+
+    Builder builder;
+    builder.StartDict();
+    builder.Key("request_id").Value(dict.at("id").AsInt());
+
+    const auto routes = handler.MakeParetoRoutes(from_stop, to_stop);
+    if (routes.empty()){
+        builder.Key("error_message").Value("not found");
     } else{
         Array array;
-        for(const RouteInfo::StopInfo& info: info->stops){
-            Dict dict;
-            dict["stop_name"]   = std::string(info.name);
-            dict["time"]        = info.time;
-            dict["type"]        = "Wait";
-            array.push_back(std::move(dict));
-        }
-        for(const RouteInfo::BusInfo& info: info->buses){
-            Dict dict;
-            dict["bus"]         = std::string(info.name),
-            dict["span_count"]  = static_cast<int>(info.span_count),
-            dict["time"]        = info.time,
-            dict["type"]        = "Bus";
-            array.push_back(std::move(dict));
+        for (const RouteInfo& route : routes){
+            Dict journey;
+            journey["items"]            = RouteItems(route);
+            journey["total_time"]       = route.total_time;
+            const auto rides = std::count_if(route.items.begin(), route.items.end(),
+                                             [](const RouteInfo::Item& item){ return std::holds_alternative<RouteInfo::BusInfo>(item); });
+            journey["transfer_count"]   = rides == 0 ? 0 : static_cast<int>(rides - 1);
+            array.push_back(std::move(journey));
         }
-        builder.Key("items").Value(std::move(array));
-        builder.Key("total_time").Value(info->total_time);
+        builder.Key("routes").Value(std::move(array));
+    }
+
+    builder.EndDict();
+    return builder.Build();
+}
+
+// Остановки в ответе на запросы NearestStops и StopsInRadius
+static json::Array NearbyStopsItems(const std::vector<NearbyStop>& stops)
+{
+    using namespace json;
+
+    Array array;
+    array.reserve(stops.size());
+    for (const NearbyStop& stop : stops){
+        Dict dict;
+        dict["distance"]    = stop.distance;
+        dict["name"]        = std::string(stop.name);
+        array.push_back(std::move(dict));
+    }
+    return array;
+}
+
+Node JsonReader::StatRequestNearestStops(const json::Dict &dict)
+{
+    using namespace json;
+
+    const Coordinates center{dict.at("latitude").AsDouble(), dict.at("longitude").AsDouble()};
+    const int count = dict.at("count").AsInt();
+    if (count < 0){
+        throw std::invalid_argument("JsonReader: negative stops count");
     }
 
+    Builder builder;
+    builder.StartDict();
+    builder.Key("request_id").Value(dict.at("id").AsInt());
+    builder.Key("stops").Value(NearbyStopsItems(handler.GetNearestStops(center, static_cast<size_t>(count))));
+    builder.EndDict();
+    return builder.Build();
+}
+
+Node JsonReader::StatRequestStopsInRadius(const json::Dict &dict)
+{
+    using namespace json;
+
+    const Coordinates center{dict.at("latitude").AsDouble(), dict.at("longitude").AsDouble()};
+    const double radius = dict.at("radius").AsDouble();
+
+    Builder builder;
+    builder.StartDict();
+    builder.Key("request_id").Value(dict.at("id").AsInt());
+    builder.Key("stops").Value(NearbyStopsItems(handler.GetStopsInRadius(center, radius)));
     builder.EndDict();
     return builder.Build();
 }
 
+void JsonReader::SetOutputFormat(json::Format format)
+{
+    output_format = format;
+}
+
 std::string JsonReader::SerializationSettings(const json::Node &node)
 {
     return node.AsDict().at("file").AsString();
@@ -16,20 +16,38 @@ using json::Dict;
 
 class JsonReader{
     RequestHandler &handler;
+    json::Format output_format = json::Format::Pretty;
 
+    Node StatRequest(const Dict &dict);
     Node StatRequestBus(const Dict &dict);
     Node StatRequestStop(const Dict &dict);
     Node StatRequestMap(const Dict &dict);
     Node StatRequestRoute(const Dict &dict);
+    Node StatRequestNearestStops(const Dict &dict);
+    Node StatRequestStopsInRadius(const Dict &dict);
+    // Запрос Route с ключом "pareto": true — все оптимальные сочетания числа пересадок и времени
+    Node StatRequestParetoRoute(const Dict &dict, const std::string &from_stop, const std::string &to_stop);
 public:
     JsonReader(RequestHandler &handler);
 
-    json::Dict ParseRequest(std::istream &input = std::cin);
+    // Разбирает запрос целиком в арену документа: документ должен жить, пока используются его узлы
+    static json::Document ParseRequest(std::istream &input = std::cin);
 
     void BaseRequestHandler(const Node &node);
     void StatRequestHandler(const Node &node, std::ostream &stream);
+    // Обрабатывает stat-запросы в формате NDJSON: по одному JSON-объекту в строке.
+    // Ответ на каждый запрос выводится отдельной строкой, как только запрос прочитан
+    void StatRequestStream(std::istream &input, std::ostream &stream);
+    // Отвечает на один stat-запрос, записанный JSON-объектом, одной строкой без перевода строки в конце.
+    // На запрос, который не удалось разобрать или обработать, отвечает error_message и, если номер
+    // запроса удалось прочитать, request_id.
+    // Не меняет состояния справочника, поэтому может вызываться из нескольких потоков одновременно
+    void StatRequestLine(std::string_view request, std::ostream &stream);
     void RenderSettingsRequestHandler(const Node &node);
     void RoutingSettingsHandler(const Node &node);
 
+    // Задаёт оформление ответов на stat-запросы
+    void SetOutputFormat(json::Format format);
+
     static std::string SerializationSettings(const Node &node);
 };
@@ -1,8 +1,17 @@
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <thread>
+
+#ifdef __linux__
+#include <csignal>
+#include <pthread.h>
+#endif
 
 #include "json_reader.h"
+#include "query_server.h"
 #include "request_handler.h"
 
 #include "test_queries.h"
@@ -11,10 +20,123 @@ using namespace std::literals;
 using json::Document;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests] [--compact] [--ndjson]\n"sv
+           << "       transport_catalogue serve <socket> [threads]\n"sv
+           << "       transport_catalogue query_client <socket> [connections]\n"sv;
+}
+
+#ifdef __linux__
+// Всё, что загружается из файла базы. Запрос обслуживается снимком, действовавшим на момент
+// его поступления; снимок освобождается, когда завершается последний использующий его запрос
+struct BaseSnapshot {
+    TransportCatalogue catalogue;
+    MapRenderer renderer;
+    TransportRouter router;
+    RequestHandler handler{catalogue, renderer, router};
+    JsonReader reader{handler};
+};
+
+std::shared_ptr<BaseSnapshot> LoadSnapshot(const std::string& path) {
+    auto snapshot = std::make_shared<BaseSnapshot>();
+    // Сервер загружает все разделы сразу: повреждённая база обнаружится до подмены рабочей,
+    // а не на первом запросе к ней
+    snapshot->handler.Deserialize(path, BaseLoading::Eager);
+    // Маршрутизаторы и индекс остановок строятся до публикации снимка, чтобы первые запросы
+    // после запуска или перезагрузки не ждали их построения
+    snapshot->handler.Warm();
+    return snapshot;
+}
+
+// Загружает базу, указанную в serialization_settings из stdin, и отвечает на stat-запросы
+// через сокет домена Unix, пока процесс не получит SIGINT или SIGTERM.
+// По сигналу SIGHUP база перечитывается в фоне и подменяет прежнюю без остановки обслуживания
+int Serve(const std::string& socket_path, size_t threads_count) {
+    const Document document = JsonReader::ParseRequest(std::cin);
+    const std::string path = JsonReader::SerializationSettings(document.GetRoot().AsDict().at("serialization_settings"));
+
+    // Текущий снимок разделяется потоком сигналов и рабочими потоками сервера
+    const auto snapshot = std::make_shared<std::shared_ptr<BaseSnapshot>>(LoadSnapshot(path));
+
+    server::QueryServer query_server({socket_path, threads_count}, [snapshot](std::string_view request) {
+        const std::shared_ptr<BaseSnapshot> current = std::atomic_load(snapshot.get());
+        std::ostringstream stream;
+        current->reader.StatRequestLine(request, stream);
+        return stream.str();
+    });
+
+    // Сигналы блокируются до запуска потоков сервера, чтобы их получал только поток сигналов
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGHUP);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    // Остановка сервера через Stop, а не завершение процесса сигналом, удаляет файл сокета
+    std::thread signals_thread([&query_server, snapshot, signals, path] {
+        int signal;
+        while (sigwait(&signals, &signal) == 0) {
+            if (signal != SIGHUP) {
+                query_server.Stop();
+                return;
+            }
+            try {
+                std::atomic_store(snapshot.get(), LoadSnapshot(path));
+            } catch (const std::exception& e) {
+                std::cerr << "Base reload failed: "sv << e.what() << '\n';
+            }
+        }
+    });
+
+    try {
+        query_server.Run();
+    } catch (...) {
+        // Поток сигналов завершается так же, как при штатной остановке
+        pthread_kill(signals_thread.native_handle(), SIGTERM);
+        signals_thread.join();
+        throw;
+    }
+    signals_thread.join();
+    return 0;
 }
+#endif
 
 int main(int argc, char* argv[]) {
+#ifdef __linux__
+    if (argc >= 3 && argv[1] == "serve"sv) {
+        return Serve(argv[2], argc >= 4 ? std::stoul(argv[3]) : 0);
+    }
+    if (argc >= 3 && argv[1] == "query_client"sv) {
+        // Запросы для нагрузки читаются из stdin по одному в строке
+        server::RunQueryClient(argv[2], std::cin, argc >= 4 ? std::stoul(argv[3]) : 1, std::cout);
+        return 0;
+    }
+#endif
+
+    // Ключ --compact включает вывод ответов без пробелов и переводов строк
+    const bool compact_output = std::any_of(argv + 1, argv + argc,
+                                            [](const char* arg) { return arg == "--compact"sv; });
+    // Ключ --ndjson включает построчный режим process_requests: первая строка содержит
+    // serialization_settings, каждая следующая — один stat-запрос
+    const bool ndjson_input = std::any_of(argv + 1, argv + argc,
+                                          [](const char* arg) { return arg == "--ndjson"sv; });
+
+    if (argc >= 2 && argv[1] == "process_requests"sv && ndjson_input) {
+        TransportCatalogue catalogue;
+        MapRenderer renderer;
+        TransportRouter router;
+
+        RequestHandler handler(catalogue, renderer, router);
+        JsonReader reader(handler);
+        reader.SetOutputFormat(compact_output ? json::Format::Compact : json::Format::Pretty);
+
+        std::string settings_line;
+        std::getline(std::cin, settings_line);
+        const Document settings = json::Load(settings_line);
+        handler.Deserialize(reader.SerializationSettings(settings.GetRoot().AsDict().at("serialization_settings")));
+        reader.StatRequestStream(std::cin, std::cout);
+        return 0;
+    }
 
     std::string file_name = "s14_3_opentest_1";
 
@@ -31,7 +153,8 @@ int main(int argc, char* argv[]) {
 
         RequestHandler handler(catalogue, renderer, router);
         JsonReader reader(handler);
-        auto requests = reader.ParseRequest(istream);
+        const Document document = reader.ParseRequest(istream);
+        const auto &requests = document.GetRoot().AsDict();
 
         if (mode == "make_base"sv) {
             if (requests.count("base_requests"))
@@ -62,7 +185,10 @@ int main(int argc, char* argv[]) {
 
         RequestHandler handler(catalogue, renderer, router);
         JsonReader reader(handler);
-        auto requests = reader.ParseRequest(in_stream);
+        reader.SetOutputFormat(compact_output ? json::Format::Compact : json::Format::Pretty);
+
+        const Document document = reader.ParseRequest(in_stream);
+        const auto &requests = document.GetRoot().AsDict();
 
         if (mode == "make_base"sv) {
             reader.BaseRequestHandler(requests.at("base_requests"));
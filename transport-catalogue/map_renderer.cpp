@@ -1,6 +1,9 @@
 #include "map_renderer.h"
 
 #include <cassert>
+#include <future>
+#include <sstream>
+#include <thread>
 #include <unordered_set>
 
 /*
@@ -11,6 +14,7 @@
 void renderer::MapRenderer::SetSettings(const MapRenderSettings &settings)
 {
     this->settings = settings;
+    layout.reset();
 }
 
 const renderer::MapRenderSettings &renderer::MapRenderer::GetSettings() const
@@ -18,11 +22,8 @@ const renderer::MapRenderSettings &renderer::MapRenderer::GetSettings() const
     return settings;
 }
 
-void renderer::MapRenderer::RenderCatalogue(const catalogue::TransportCatalogue &catalogue, std::ostream& out = std::cout)
+renderer::MapLayout renderer::MapRenderer::MakeLayout(const catalogue::TransportCatalogue &catalogue) const
 {
-    using namespace svg;
-    using svg::Circle;
-
     std::unordered_set<std::string> unique_stops;
     std::vector<std::string> buses = catalogue.GetBuses();
     std::unordered_map<std::string, std::vector<std::string>> buses_to_stops;
@@ -35,60 +36,197 @@ void renderer::MapRenderer::RenderCatalogue(const catalogue::TransportCatalogue
     std::vector<std::string> stops(unique_stops.begin(), unique_stops.end());
     std::sort(stops.begin(), stops.end());
 
-    std::deque<Coordinates> stops_coordinates;
-    std::unordered_map<std::string_view, Coordinates*> stops_to_coordinates;
-    std::for_each(unique_stops.begin(), unique_stops.end(),
-                  [&stops_coordinates, &stops_to_coordinates, &catalogue](const std::string_view stop)
-    {
+    // Координаты всех остановок собираются в структуру массивов и проецируются за один проход
+    CoordinatesArray stops_coordinates;
+    stops_coordinates.reserve(stops.size());
+    for (const auto &stop : stops){
         stops_coordinates.push_back(*catalogue.GetStopCoordinates(stop));
-        stops_to_coordinates[stop] = &stops_coordinates.back();
-    });
+    }
 
     const auto &render_settinds = GetSettings();
-    SphereProjector projector(stops_coordinates.begin(),
-                              stops_coordinates.end(),
+    SphereProjector projector(stops_coordinates,
                               render_settinds.width,
                               render_settinds.height,
                               render_settinds.padding);
 
+    std::vector<double> stops_x;
+    std::vector<double> stops_y;
+    projector(stops_coordinates, stops_x, stops_y);
 
-    std::unordered_map<std::string, Point> stops_to_points;
-    for (const auto &stop : unique_stops){
-        stops_to_points[stop] = projector(*stops_to_coordinates.at(stop));
+    MapLayout layout;
+    layout.stops.reserve(stops.size());
+    std::unordered_map<std::string_view, size_t> stops_to_index;
+    stops_to_index.reserve(stops.size());
+    for (size_t i = 0; i < stops.size(); ++i){
+        stops_to_index[stops[i]] = i;
+        layout.stops.push_back({stops[i], svg::Point{stops_x[i], stops_y[i]}});
     }
 
-    std::deque<Polyline> lines;
-    std::deque<Text> buses_names;
-
+    // Цвета назначаются заранее в порядке сортировки маршрутов, поэтому результат
+    // не зависит от того, в каком потоке и в каком порядке будут построены линии
+    layout.buses.reserve(buses.size());
+    const size_t palette_size = std::max<size_t>(1, settings.color_palette.size());
+    size_t color_index = 0;
     for (const auto &bus : buses){
-        if (buses_to_stops.at(bus).empty())
+        const auto &bus_stops = buses_to_stops.at(bus);
+        if (bus_stops.empty())
             continue;
 
-        auto stops = std::move(buses_to_stops.at(bus));
+        std::vector<size_t> bus_stops_indexes(bus_stops.size());
+        std::transform(bus_stops.begin(), bus_stops.end(),
+                       bus_stops_indexes.begin(),
+                       [&stops_to_index](const auto &stop_name){ return stops_to_index.at(stop_name); });
+
+        layout.buses.push_back({bus,
+                                std::move(bus_stops_indexes),
+                                catalogue.GetBusType(bus) == Linear,
+                                color_index++ % palette_size});
+    }
+
+    return layout;
+}
+
+void renderer::MapRenderer::SetLayout(MapLayout layout)
+{
+    this->layout = std::move(layout);
+}
 
-        std::vector<Point> stops_points(stops.size());
-        std::transform(stops.begin(), stops.end(),
-                       stops_points.begin(),
-                       [&stops_to_points](auto &stop_name){ return stops_to_points[stop_name]; });
+const std::optional<renderer::MapLayout> &renderer::MapRenderer::GetLayout() const
+{
+    return layout;
+}
 
-        AddBusLine(bus, stops_points, catalogue.GetBusType(bus) == Linear);
+void renderer::MapRenderer::RenderCatalogue(const catalogue::TransportCatalogue &catalogue, std::ostream& out) const
+{
+    if (layout) {
+        RenderLayout(*layout, out);
+    } else {
+        RenderLayout(MakeLayout(catalogue), out);
     }
+}
 
-    for (const auto &stop : stops){
-        AddStopPoint(stop, stops_to_points.at(stop));
+void renderer::MapRenderer::RenderLayout(const MapLayout &layout, std::ostream &out) const
+{
+    using svg::Document;
+
+    // Слои делятся на фрагменты по порядку, так что вывод фрагментов
+    // друг за другом даёт тот же документ, что и однопоточная отрисовка
+    std::vector<Fragment> fragments;
+    auto split = [&fragments](Layer layer, size_t items_count){
+        for (size_t begin = 0; begin < items_count; begin += items_per_fragment){
+            fragments.push_back({layer, begin, std::min(begin + items_per_fragment, items_count)});
+        }
+    };
+    split(Layer::BusLines, layout.buses.size());
+    split(Layer::BusTitles, layout.buses.size());
+    split(Layer::StopPoints, layout.stops.size());
+    split(Layer::StopTitles, layout.stops.size());
+
+    const size_t threads_count = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(),
+                                                                      fragments.size()));
+    const auto policy = threads_count == 1 ? std::launch::deferred : std::launch::async;
+    const NumberFormat format{out.precision(), out.flags()};
+
+    // Одновременно отрисовывается не больше threads_count фрагментов. Каждый фрагмент
+    // записывается в поток, как только готов он и все предыдущие, и сразу освобождается:
+    // если поток сжимает данные, в памяти не окажется весь несжатый документ
+    Document::RenderHeader(out);
+    std::deque<std::future<std::string>> pending;
+    for (size_t next = 0; next < fragments.size() || !pending.empty(); ){
+        while (next < fragments.size() && pending.size() < threads_count){
+            pending.push_back(std::async(policy, [this, &layout, &fragment = fragments[next], format]{
+                return RenderFragment(layout, fragment, format);
+            }));
+            ++next;
+        }
+        out << pending.front().get();
+        pending.pop_front();
     }
-    Render(out);
+    Document::RenderFooter(out);
 }
 
-void renderer::MapRenderer::AddStopPoint(const std::string_view title, const svg::Point &position)
+std::string renderer::MapRenderer::RenderFragment(const MapLayout &layout, const Fragment &fragment,
+                                                  NumberFormat format) const
 {
-    using svg::Text;
-    using svg::Circle;
+    using svg::Point;
+
+    // Фрагменты выводятся с тем же форматированием чисел, что и итоговый поток
+    std::ostringstream stream;
+    stream.precision(format.precision);
+    stream.flags(format.flags);
+    auto render = [&stream](const auto &objects){
+        for (const auto &object : objects){
+            object.Render({stream, 2, 2});
+        }
+    };
+    auto position = [&layout](const size_t stop_index){
+        return layout.stops.at(stop_index).position;
+    };
 
-    auto point = Circle()
+    // Строятся только объекты слоя, к которому относится фрагмент
+    switch (fragment.layer) {
+    case Layer::BusLines: {
+        std::deque<svg::Polyline> lines;
+        for (size_t i = fragment.begin; i < fragment.end; ++i){
+            const MapLayout::BusLine &bus = layout.buses[i];
+            std::vector<Point> points(bus.stops.size());
+            std::transform(bus.stops.begin(), bus.stops.end(), points.begin(), position);
+            AddBusLine(lines, std::move(points), bus.is_linear, GetBusColor(bus));
+        }
+        render(lines);
+        break;
+    }
+    case Layer::BusTitles: {
+        std::deque<svg::Text> titles;
+        for (size_t i = fragment.begin; i < fragment.end; ++i){
+            const MapLayout::BusLine &bus = layout.buses[i];
+            assert(!bus.stops.empty());
+            AddBusTitles(titles, bus.title, position(bus.stops.front()), position(bus.stops.back()),
+                         bus.is_linear, GetBusColor(bus));
+        }
+        render(titles);
+        break;
+    }
+    case Layer::StopPoints: {
+        std::deque<svg::Circle> points;
+        for (size_t i = fragment.begin; i < fragment.end; ++i){
+            AddStopPoint(points, layout.stops[i].position);
+        }
+        render(points);
+        break;
+    }
+    case Layer::StopTitles: {
+        std::deque<svg::Text> titles;
+        for (size_t i = fragment.begin; i < fragment.end; ++i){
+            AddStopTitles(titles, layout.stops[i].title, layout.stops[i].position);
+        }
+        render(titles);
+        break;
+    }
+    }
+    return stream.str();
+}
+
+svg::Color renderer::MapRenderer::GetBusColor(const MapLayout::BusLine &bus) const
+{
+    // При пустой палитре линии выводятся без цвета
+    if (settings.color_palette.empty()){
+        return {};
+    }
+    return settings.color_palette[bus.color_index % settings.color_palette.size()];
+}
+
+void renderer::MapRenderer::AddStopPoint(std::deque<svg::Circle> &points, const svg::Point &position) const
+{
+    points.push_back(svg::Circle()
             .SetCenter(position)
             .SetRadius(settings.stop_radius)
-            .SetFillColor("white");
+            .SetFillColor("white"));
+}
+
+void renderer::MapRenderer::AddStopTitles(std::deque<svg::Text> &titles, const std::string_view title, const svg::Point &position) const
+{
+    using svg::Text;
 
     auto text = Text()
             .SetData(std::string(title))
@@ -110,50 +248,17 @@ void renderer::MapRenderer::AddStopPoint(const std::string_view title, const svg
             .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
             .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
-    stop_points.push_back(std::move(point));
-    stop_titles.push_back(std::move(text_bottom));
-    stop_titles.push_back(std::move(text));
+    titles.push_back(std::move(text_bottom));
+    titles.push_back(std::move(text));
 }
 
-void renderer::MapRenderer::AddBusLine(const std::string_view title, std::vector<svg::Point> points, bool isLinear)
+void renderer::MapRenderer::AddBusLine(std::deque<svg::Polyline> &lines, std::vector<svg::Point> points,
+                                       bool isLinear, const svg::Color &color) const
 {
     assert(!points.empty());
 
-    using svg::Text;
-    using svg::Color;
     using svg::Polyline;
 
-    Color color = settings.color_palette.at((color_index++) % settings.color_palette.size());
-    auto text = Text()
-            .SetData(std::string(title))
-            .SetFillColor(color)
-            .SetPosition(points.front())
-            .SetOffset(settings.bus_label_offset)
-            .SetFontSize(settings.bus_label_font_size)
-            .SetFontFamily("Verdana")
-            .SetFontWeight("bold");
-    auto text_bottom = Text()
-            .SetData(std::string(title))
-            .SetFillColor(settings.underlayer_color)
-            .SetPosition(points.front())
-            .SetStrokeColor(settings.underlayer_color)
-            .SetStrokeWidth(settings.underlayer_width)
-            .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-            .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND)
-            .SetPosition(points.front())
-            .SetOffset(settings.bus_label_offset)
-            .SetFontSize(settings.bus_label_font_size)
-            .SetFontFamily("Verdana")
-            .SetFontWeight("bold");
-
-    bus_titles.push_back(Text(text_bottom));
-    bus_titles.push_back(Text(text));
-
-    if ((points.front() != points.back()) && isLinear){
-        bus_titles.push_back(Text(text_bottom).SetPosition(points.back()));
-        bus_titles.push_back(Text(text).SetPosition(points.back()));
-    }
-
     if (isLinear){
         points.resize(points.size() * 2 - 1);
         std::copy(points.begin(), points.begin() + points.size() / 2,
@@ -170,28 +275,42 @@ void renderer::MapRenderer::AddBusLine(const std::string_view title, std::vector
     for (auto point : points)
         line.AddPoint(point);
 
-    bus_lines.push_back(std::move(line));
+    lines.push_back(std::move(line));
 }
 
-void renderer::MapRenderer::Render(std::ostream &stream)
+void renderer::MapRenderer::AddBusTitles(std::deque<svg::Text> &titles, const std::string_view title,
+                                         const svg::Point &first, const svg::Point &last,
+                                         bool isLinear, const svg::Color &color) const
 {
-    using svg::Polyline;
-    using svg::Text;
-    using svg::Circle;
     using svg::Text;
 
-    for (Polyline &line : bus_lines){
-        doc.Add(std::move(line));
-    }
-    for (Text &text : bus_titles){
-        doc.Add(std::move(text));
-    }
-    for (Circle &point : stop_points){
-        doc.Add(std::move(point));
-    }
-    for (Text &text : stop_titles){
-        doc.Add(std::move(text));
-    }
+    auto text = Text()
+            .SetData(std::string(title))
+            .SetFillColor(color)
+            .SetPosition(first)
+            .SetOffset(settings.bus_label_offset)
+            .SetFontSize(settings.bus_label_font_size)
+            .SetFontFamily("Verdana")
+            .SetFontWeight("bold");
+    auto text_bottom = Text()
+            .SetData(std::string(title))
+            .SetFillColor(settings.underlayer_color)
+            .SetPosition(first)
+            .SetStrokeColor(settings.underlayer_color)
+            .SetStrokeWidth(settings.underlayer_width)
+            .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
+            .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND)
+            .SetPosition(first)
+            .SetOffset(settings.bus_label_offset)
+            .SetFontSize(settings.bus_label_font_size)
+            .SetFontFamily("Verdana")
+            .SetFontWeight("bold");
 
-    doc.Render(stream);
+    titles.push_back(Text(text_bottom));
+    titles.push_back(Text(text));
+
+    if ((first != last) && isLinear){
+        titles.push_back(Text(text_bottom).SetPosition(last));
+        titles.push_back(Text(text).SetPosition(last));
+    }
 }
@@ -2,6 +2,8 @@
 
 #include <vector>
 #include <deque>
+#include <optional>
+#include <string>
 
 #include "svg.h"
 #include "transport_catalogue.h"
@@ -30,24 +32,76 @@ namespace renderer {
         std::vector<svg::Color> color_palette;  ///< цветовая палитра. Непустой массив.
     };
 
+    // Подготовленная к выводу карта: экранные координаты отрисовываемых остановок и
+    // назначенные маршрутам цвета. Не зависит от справочника и может быть сохранена в базе
+    struct MapLayout{
+        struct BusLine{
+            std::string title;
+            std::vector<size_t> stops;          ///< индексы остановок маршрута в MapLayout::stops
+            bool is_linear;
+            size_t color_index;                 ///< индекс цвета в палитре
+        };
+
+        struct StopPoint{
+            std::string title;
+            svg::Point position;
+        };
+
+        std::vector<BusLine> buses;             ///< маршруты, упорядоченные по названию
+        std::vector<StopPoint> stops;           ///< остановки, упорядоченные по названию
+    };
+
     class MapRenderer{
-        svg::Document doc;
-        std::deque<svg::Text> stop_titles;
-        std::deque<svg::Circle> stop_points;
+        // Слои карты в порядке их вывода
+        enum class Layer{
+            BusLines,
+            BusTitles,
+            StopPoints,
+            StopTitles
+        };
 
-        std::deque<svg::Text> bus_titles;
-        std::deque<svg::Polyline> bus_lines;
+        // Часть одного слоя: непрерывный диапазон маршрутов или остановок карты
+        struct Fragment{
+            Layer layer;
+            size_t begin;
+            size_t end;
+        };
+
+        // Число элементов карты в одном фрагменте. Ограничивает объём несжатого svg,
+        // который хранится в памяти до записи в выходной поток
+        static constexpr size_t items_per_fragment = 256;
 
-        size_t color_index = 0;
         MapRenderSettings settings;
+        std::optional<MapLayout> layout;
+
+        // Форматирование чисел выходного потока. Считывается до запуска потоков отрисовки,
+        // которые не обращаются к самому выходному потоку
+        struct NumberFormat{
+            std::streamsize precision;
+            std::ios_base::fmtflags flags;
+        };
+
+        std::string RenderFragment(const MapLayout& layout, const Fragment& fragment, NumberFormat format) const;
+
+        svg::Color GetBusColor(const MapLayout::BusLine& bus) const;
+        void AddBusLine(std::deque<svg::Polyline>& lines, std::vector<svg::Point> points,
+                        bool isLinear, const svg::Color& color) const;
+        void AddBusTitles(std::deque<svg::Text>& titles, const std::string_view title,
+                          const svg::Point& first, const svg::Point& last, bool isLinear, const svg::Color& color) const;
+        void AddStopPoint(std::deque<svg::Circle>& points, const svg::Point &position) const;
+        void AddStopTitles(std::deque<svg::Text>& titles, const std::string_view title, const svg::Point &position) const;
     public:
         void SetSettings(const MapRenderSettings &settings);
         const MapRenderSettings &GetSettings() const;
 
-        void RenderCatalogue(const catalogue::TransportCatalogue& catalogue, std::ostream &out);
+        ///[\brief] Вычисляет расположение маршрутов и остановок на карте по текущим настройкам
+        MapLayout MakeLayout(const catalogue::TransportCatalogue& catalogue) const;
+        ///[\brief] Задаёт заранее вычисленную карту. Сбрасывается при изменении настроек
+        void SetLayout(MapLayout layout);
+        const std::optional<MapLayout> &GetLayout() const;
 
-        void AddStopPoint(const std::string_view title, const svg::Point &position);
-        void AddBusLine(const std::string_view title, std::vector<svg::Point> points, bool isLinear);
-        void Render(std::ostream&);
+        ///[\brief] Выводит карту справочника. Если карта была задана заранее, справочник не используется
+        void RenderCatalogue(const catalogue::TransportCatalogue& catalogue, std::ostream &out) const;
+        void RenderLayout(const MapLayout& layout, std::ostream &out) const;
     };
 }
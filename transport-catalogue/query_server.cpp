@@ -0,0 +1,637 @@
+#include "query_server.h"
+
+#ifdef __linux__
+
+#include "json_builder.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace server {
+
+namespace {
+
+[[noreturn]] void ThrowSystemError(const char* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Закрывает дескриптор при выходе из области видимости
+class FileDescriptor {
+public:
+    explicit FileDescriptor(int fd = -1)
+        : fd_(fd) {
+    }
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    ~FileDescriptor() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    int Get() const {
+        return fd_;
+    }
+
+private:
+    int fd_;
+};
+
+sockaddr_un MakeAddress(const std::string& socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("QueryServer: socket path is too long");
+    }
+    std::copy(socket_path.begin(), socket_path.end(), address.sun_path);
+    return address;
+}
+
+// Простой пул потоков, выполняющий задачи в порядке поступления
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads_count) {
+        threads_.reserve(threads_count);
+        for (size_t i = 0; i < threads_count; ++i) {
+            threads_.emplace_back([this]{ Work(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stopped_ = true;
+        }
+        condition_.notify_all();
+        for (auto &thread : threads_) {
+            thread.join();
+        }
+    }
+
+    void Submit(std::function<void()> task) {
+        {
+            std::lock_guard lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        condition_.notify_one();
+    }
+
+private:
+    void Work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mutex_);
+                condition_.wait(lock, [this]{ return stopped_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopped_ = false;
+};
+
+// Состояние соединения. Поля под mutex разделяются циклом событий и рабочим потоком,
+// который обрабатывает запросы этого соединения
+struct Connection {
+    explicit Connection(int fd)
+        : fd(fd) {
+    }
+
+    const int fd;
+    std::string input;              // непрочитанный остаток строки запроса, только для цикла событий
+    bool input_closed = false;      // клиент больше ничего не пришлёт
+    bool writing = false;           // на сокете ожидается готовность к записи
+    bool throttled = false;         // чтение приостановлено, пока не отправится часть ответов
+    bool queue_full = false;        // чтение приостановлено, пока не обработается часть запросов
+
+    std::mutex mutex;
+    std::deque<std::string> requests;
+    size_t requests_size = 0;       // суммарная длина запросов в очереди
+    std::string output;
+    size_t output_offset = 0;
+    bool busy = false;              // запросы соединения обрабатываются рабочим потоком
+    bool closed = false;
+};
+
+// Ответ на запрос, который не удалось обработать. Если строка запроса — JSON-объект
+// с целым id, ответ содержит request_id, чтобы клиент мог сопоставить его с запросом
+std::string ErrorResponse(std::string_view request, const std::string& message) {
+    json::Builder builder;
+    builder.StartDict();
+    try {
+        const json::Document document = json::Load(request);
+        if (document.GetRoot().IsDict()) {
+            const json::Dict& dict = document.GetRoot().AsDict();
+            if (const auto id = dict.find("id"); id != dict.end() && id->second.IsInt()) {
+                builder.Key("request_id").Value(id->second.AsInt());
+            }
+        }
+    } catch (const std::exception&) {
+        // Запрос не разобран — ответ без request_id
+    }
+    builder.Key("error_message").Value(message);
+
+    std::ostringstream stream;
+    json::Print(json::Document(builder.EndDict().Build()), stream, json::Format::Compact);
+    return stream.str();
+}
+
+// Цикл событий одного запуска QueryServer::Run
+class EventLoop {
+public:
+    EventLoop(const ServerSettings& settings, const QueryServer::RequestHandler& handler, int wake_fd,
+              const std::atomic<bool>& stopped)
+        : handler_(handler)
+        , max_request_size_(settings.max_request_size)
+        , output_high_water_mark_(settings.output_high_water_mark)
+        , input_high_water_mark_(settings.input_high_water_mark)
+        , wake_fd_(wake_fd)
+        , stopped_(stopped)
+        , listen_fd_(socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0))
+        , epoll_fd_(epoll_create1(EPOLL_CLOEXEC))
+        , pool_(settings.threads_count > 0 ? settings.threads_count
+                                           : std::max(1u, std::thread::hardware_concurrency())) {
+        if (listen_fd_.Get() < 0) {
+            ThrowSystemError("QueryServer: socket");
+        }
+        if (epoll_fd_.Get() < 0) {
+            ThrowSystemError("QueryServer: epoll_create1");
+        }
+
+        const sockaddr_un address = MakeAddress(settings.socket_path);
+        unlink(settings.socket_path.c_str());
+        if (bind(listen_fd_.Get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+            ThrowSystemError("QueryServer: bind");
+        }
+        if (listen(listen_fd_.Get(), SOMAXCONN) < 0) {
+            ThrowSystemError("QueryServer: listen");
+        }
+
+        Watch(listen_fd_.Get(), EPOLLIN, EPOLL_CTL_ADD);
+        Watch(wake_fd_, EPOLLIN, EPOLL_CTL_ADD);
+    }
+
+    ~EventLoop() {
+        for (const auto &[fd, connection] : connections_) {
+            std::lock_guard lock(connection->mutex);
+            connection->closed = true;
+            close(fd);
+        }
+    }
+
+    void Run() {
+        std::array<epoll_event, 64> events;
+        while (!stopped_) {
+            const int count = epoll_wait(epoll_fd_.Get(), events.data(), static_cast<int>(events.size()), -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ThrowSystemError("QueryServer: epoll_wait");
+            }
+            for (int i = 0; i < count; ++i) {
+                const int fd = events[i].data.fd;
+                if (fd == listen_fd_.Get()) {
+                    Accept();
+                } else if (fd == wake_fd_) {
+                    FlushReady();
+                } else if (const auto it = connections_.find(fd); it != connections_.end()) {
+                    // Копия указателя: закрытие соединения удаляет его из таблицы
+                    const std::shared_ptr<Connection> connection = it->second;
+                    HandleEvents(connection, events[i].events);
+                }
+            }
+        }
+    }
+
+private:
+    void Watch(int fd, uint32_t events, int operation) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_.Get(), operation, fd, &event) < 0) {
+            ThrowSystemError("QueryServer: epoll_ctl");
+        }
+    }
+
+    // Подписывается на чтение, пока клиент может прислать запросы и чтение не приостановлено,
+    // и на запись, пока есть неотправленные ответы
+    void UpdateWatch(const Connection& connection) {
+        const bool reading = !connection.input_closed && !connection.throttled && !connection.queue_full;
+        Watch(connection.fd,
+              (reading ? static_cast<uint32_t>(EPOLLIN | EPOLLRDHUP) : 0u)
+                  | (connection.writing ? static_cast<uint32_t>(EPOLLOUT) : 0u),
+              EPOLL_CTL_MOD);
+    }
+
+    void Accept() {
+        while (true) {
+            const int fd = accept4(listen_fd_.Get(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    std::cerr << "QueryServer: accept: " << std::strerror(errno) << '\n';
+                }
+                return;
+            }
+            connections_.emplace(fd, std::make_shared<Connection>(fd));
+            Watch(fd, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_ADD);
+        }
+    }
+
+    void HandleEvents(const std::shared_ptr<Connection>& connection, uint32_t events) {
+        // Клиент, закрывший соединение полностью, ответов уже не прочитает
+        if ((events & EPOLLERR) || ((events & EPOLLHUP) && connection->input_closed)) {
+            Close(connection);
+            return;
+        }
+        if (!connection->input_closed && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))) {
+            Read(connection);
+        }
+        if (connections_.count(connection->fd) && (events & EPOLLOUT)) {
+            Flush(connection);
+        }
+    }
+
+    void Read(const std::shared_ptr<Connection>& connection) {
+        std::array<char, 16 * 1024> buffer;
+        std::vector<std::string> lines;
+        size_t queued_size;
+        {
+            std::lock_guard lock(connection->mutex);
+            queued_size = connection->requests_size;
+        }
+        // Остаток данных клиента подождёт в сокете, пока очередь соединения не разгрузится.
+        // Очередь превышает порог не больше чем на один буфер чтения
+        while (queued_size <= input_high_water_mark_) {
+            const ssize_t size = recv(connection->fd, buffer.data(), buffer.size(), 0);
+            if (size > 0) {
+                queued_size += static_cast<size_t>(size);
+                if (!SplitLines(*connection, {buffer.data(), static_cast<size_t>(size)}, lines)) {
+                    std::cerr << "QueryServer: request exceeds " << max_request_size_ << " bytes, closing connection\n";
+                    Close(connection);
+                    return;
+                }
+            } else if (size == 0) {
+                connection->input_closed = true;
+                break;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else {
+                Close(connection);
+                return;
+            }
+        }
+        if (connection->input_closed) {
+            // Последний запрос может быть не завершён переводом строки
+            if (!connection->input.empty()) {
+                lines.push_back(std::move(connection->input));
+                connection->input.clear();
+            }
+            UpdateWatch(*connection);
+        }
+
+        bool start = false;
+        bool queue_full;
+        {
+            std::lock_guard lock(connection->mutex);
+            for (auto &line : lines) {
+                connection->requests_size += line.size();
+                connection->requests.push_back(std::move(line));
+            }
+            if (!connection->busy && !connection->requests.empty()) {
+                connection->busy = true;
+                start = true;
+            }
+            queue_full = connection->requests_size > input_high_water_mark_;
+        }
+        if (start) {
+            pool_.Submit([this, connection]{ Process(connection); });
+        }
+        // Чтение возобновит Flush, когда рабочий поток разберёт очередь
+        if (queue_full != connection->queue_full) {
+            connection->queue_full = queue_full;
+            UpdateWatch(*connection);
+        }
+        CloseIfDone(connection);
+    }
+
+    // Возвращает false, если строка запроса длиннее max_request_size_
+    bool SplitLines(Connection& connection, std::string_view data, std::vector<std::string>& lines) const {
+        while (!data.empty()) {
+            const size_t line_end = data.find('\n');
+            const size_t size = line_end == std::string_view::npos ? data.size() : line_end;
+            if (connection.input.size() + size > max_request_size_) {
+                return false;
+            }
+            if (line_end == std::string_view::npos) {
+                connection.input.append(data);
+                return true;
+            }
+            connection.input.append(data.substr(0, line_end));
+            if (connection.input.find_first_not_of(" \t\r") != std::string::npos) {
+                lines.push_back(std::move(connection.input));
+            }
+            connection.input.clear();
+            data.remove_prefix(line_end + 1);
+        }
+        return true;
+    }
+
+    // Выполняется в рабочем потоке: отвечает на запросы соединения по порядку, пока они не кончатся
+    void Process(const std::shared_ptr<Connection>& connection) {
+        while (true) {
+            std::string request;
+            {
+                std::lock_guard lock(connection->mutex);
+                if (connection->requests.empty() || connection->closed) {
+                    connection->busy = false;
+                    break;
+                }
+                request = std::move(connection->requests.front());
+                connection->requests.pop_front();
+                connection->requests_size -= request.size();
+            }
+
+            std::string response;
+            try {
+                response = handler_(request);
+            } catch (const std::exception& e) {
+                response = ErrorResponse(request, e.what());
+            }
+            response.push_back('\n');
+
+            {
+                std::lock_guard lock(connection->mutex);
+                connection->output += response;
+            }
+            Notify(connection);
+        }
+        Notify(connection);
+    }
+
+    // Передаёт соединение с готовыми ответами в цикл событий
+    void Notify(const std::shared_ptr<Connection>& connection) {
+        {
+            std::lock_guard lock(ready_mutex_);
+            ready_.push_back(connection);
+        }
+        const uint64_t one = 1;
+        [[maybe_unused]] const ssize_t written = write(wake_fd_, &one, sizeof(one));
+    }
+
+    void FlushReady() {
+        uint64_t counter;
+        [[maybe_unused]] const ssize_t size = read(wake_fd_, &counter, sizeof(counter));
+
+        std::vector<std::shared_ptr<Connection>> ready;
+        {
+            std::lock_guard lock(ready_mutex_);
+            ready.swap(ready_);
+        }
+        for (const auto &connection : ready) {
+            if (connections_.count(connection->fd) && connections_.at(connection->fd) == connection) {
+                Flush(connection);
+            }
+        }
+    }
+
+    void Flush(const std::shared_ptr<Connection>& connection) {
+        bool pending;
+        bool throttled;
+        bool queue_full;
+        {
+            std::lock_guard lock(connection->mutex);
+            std::string& output = connection->output;
+            while (connection->output_offset < output.size()) {
+                const ssize_t size = send(connection->fd, output.data() + connection->output_offset,
+                                          output.size() - connection->output_offset, MSG_NOSIGNAL);
+                if (size >= 0) {
+                    connection->output_offset += static_cast<size_t>(size);
+                } else if (errno == EINTR) {
+                    continue;
+                } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                } else {
+                    output.clear();
+                    connection->output_offset = 0;
+                    connection->input_closed = true;
+                    connection->requests.clear();
+                    connection->requests_size = 0;
+                    break;
+                }
+            }
+            if (connection->output_offset == output.size()) {
+                output.clear();
+                connection->output_offset = 0;
+            }
+            pending = !output.empty();
+            throttled = output.size() - connection->output_offset > output_high_water_mark_;
+            queue_full = connection->requests_size > input_high_water_mark_;
+        }
+
+        // Клиент, который не успевает читать ответы или присылает запросы быстрее, чем они
+        // обрабатываются, не может накопить их сколько угодно
+        if (pending != connection->writing || throttled != connection->throttled
+            || queue_full != connection->queue_full) {
+            connection->writing = pending;
+            connection->throttled = throttled;
+            connection->queue_full = queue_full;
+            UpdateWatch(*connection);
+        }
+        CloseIfDone(connection);
+    }
+
+    // Закрывает соединение, когда клиент закончил передачу и все ответы отправлены
+    void CloseIfDone(const std::shared_ptr<Connection>& connection) {
+        if (!connection->input_closed || !connections_.count(connection->fd)) {
+            return;
+        }
+        {
+            std::lock_guard lock(connection->mutex);
+            if (connection->busy || !connection->requests.empty() || !connection->output.empty()) {
+                return;
+            }
+        }
+        Close(connection);
+    }
+
+    void Close(const std::shared_ptr<Connection>& connection) {
+        {
+            std::lock_guard lock(connection->mutex);
+            connection->closed = true;
+        }
+        epoll_ctl(epoll_fd_.Get(), EPOLL_CTL_DEL, connection->fd, nullptr);
+        close(connection->fd);
+        connections_.erase(connection->fd);
+    }
+
+    const QueryServer::RequestHandler& handler_;
+    const size_t max_request_size_;
+    const size_t output_high_water_mark_;
+    const size_t input_high_water_mark_;
+    const int wake_fd_;
+    const std::atomic<bool>& stopped_;
+
+    FileDescriptor listen_fd_;
+    FileDescriptor epoll_fd_;
+    std::unordered_map<int, std::shared_ptr<Connection>> connections_;
+
+    std::mutex ready_mutex_;
+    std::vector<std::shared_ptr<Connection>> ready_;
+
+    // Объявлен последним: рабочие потоки завершаются раньше, чем разрушается состояние цикла
+    ThreadPool pool_;
+};
+
+}  // namespace
+
+QueryServer::QueryServer(ServerSettings settings, RequestHandler handler)
+    : settings_(std::move(settings))
+    , handler_(std::move(handler))
+    , wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (wake_fd_ < 0) {
+        ThrowSystemError("QueryServer: eventfd");
+    }
+}
+
+QueryServer::~QueryServer() {
+    close(wake_fd_);
+}
+
+void QueryServer::Run() {
+    EventLoop loop(settings_, handler_, wake_fd_, stopped_);
+    loop.Run();
+    unlink(settings_.socket_path.c_str());
+}
+
+void QueryServer::Stop() {
+    stopped_ = true;
+    const uint64_t one = 1;
+    [[maybe_unused]] const ssize_t written = write(wake_fd_, &one, sizeof(one));
+}
+
+void RunQueryClient(const std::string& socket_path, std::istream& requests, size_t connections_count,
+                    std::ostream& report) {
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(requests, line);) {
+        if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            line.push_back('\n');
+            lines.push_back(std::move(line));
+        }
+    }
+
+    const sockaddr_un address = MakeAddress(socket_path);
+    std::vector<std::vector<Clock::duration>> latencies(connections_count);
+    std::vector<std::thread> threads;
+    std::mutex errors_mutex;
+    std::vector<std::string> errors;
+
+    const auto start = Clock::now();
+    for (size_t i = 0; i < connections_count; ++i) {
+        threads.emplace_back([&, i]{
+            try {
+                FileDescriptor fd(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+                if (fd.Get() < 0) {
+                    ThrowSystemError("QueryClient: socket");
+                }
+                if (connect(fd.Get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+                    ThrowSystemError("QueryClient: connect");
+                }
+
+                std::string input;
+                std::array<char, 16 * 1024> buffer;
+                latencies[i].reserve(lines.size());
+                for (const std::string& line : lines) {
+                    const auto sent = Clock::now();
+                    for (size_t offset = 0; offset < line.size();) {
+                        const ssize_t size = send(fd.Get(), line.data() + offset, line.size() - offset, MSG_NOSIGNAL);
+                        if (size < 0) {
+                            ThrowSystemError("QueryClient: send");
+                        }
+                        offset += static_cast<size_t>(size);
+                    }
+                    // Ответ на запрос — ровно одна строка
+                    size_t line_end;
+                    while ((line_end = input.find('\n')) == std::string::npos) {
+                        const ssize_t size = recv(fd.Get(), buffer.data(), buffer.size(), 0);
+                        if (size <= 0) {
+                            throw std::runtime_error("QueryClient: connection closed by server");
+                        }
+                        input.append(buffer.data(), static_cast<size_t>(size));
+                    }
+                    input.erase(0, line_end + 1);
+                    latencies[i].push_back(Clock::now() - sent);
+                }
+            } catch (const std::exception& e) {
+                std::lock_guard lock(errors_mutex);
+                errors.push_back(e.what());
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    const auto elapsed = Clock::now() - start;
+
+    std::vector<Clock::duration> all;
+    for (const auto &connection_latencies : latencies) {
+        all.insert(all.end(), connection_latencies.begin(), connection_latencies.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    using Microseconds = std::chrono::duration<double, std::micro>;
+    auto percentile = [&all](double p) {
+        return all.empty() ? 0.0 : Microseconds(all[static_cast<size_t>(p * (all.size() - 1))]).count();
+    };
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+
+    report << "connections: " << connections_count << '\n'
+           << "requests: " << all.size() << '\n'
+           << "elapsed, s: " << seconds << '\n'
+           << "throughput, req/s: " << (seconds > 0 ? all.size() / seconds : 0.0) << '\n'
+           << "latency p50, us: " << percentile(0.5) << '\n'
+           << "latency p99, us: " << percentile(0.99) << '\n'
+           << "latency max, us: " << percentile(1.0) << '\n';
+    for (const auto &error : errors) {
+        report << "error: " << error << '\n';
+    }
+}
+
+}  // namespace server
+
+#endif
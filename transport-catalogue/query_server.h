@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+/*
+ * Долгоживущий сервер stat-запросов на сокете домена Unix.
+ *
+ * Протокол построчный, как в режиме --ndjson: клиент пишет по одному JSON-объекту запроса в строке,
+ * сервер отвечает одной строкой на каждый запрос в порядке их поступления по этому соединению.
+ * Соединения обслуживает один поток с циклом epoll, запросы обрабатывает пул рабочих потоков.
+ */
+
+namespace server {
+
+struct ServerSettings {
+    std::string socket_path;
+    size_t threads_count = 0;   ///< 0 — по числу аппаратных потоков
+    size_t max_request_size = 1 << 20;          ///< соединение с более длинной строкой запроса закрывается
+    size_t output_high_water_mark = 4 << 20;    ///< пока неотправленных ответов больше, запросы соединения не читаются
+    size_t input_high_water_mark = 4 << 20;     ///< пока необработанных запросов больше, запросы соединения не читаются
+};
+
+class QueryServer {
+public:
+    // Возвращает ответ на запрос, записанный в строке. Вызывается одновременно из нескольких потоков
+    using RequestHandler = std::function<std::string(std::string_view request)>;
+
+    QueryServer(ServerSettings settings, RequestHandler handler);
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+    ~QueryServer();
+
+    // Принимает соединения и обслуживает запросы, пока не будет вызван Stop
+    void Run();
+    // Завершает Run. Может вызываться из любого потока, в том числе до Run — тогда Run сразу вернёт управление
+    void Stop();
+
+private:
+    ServerSettings settings_;
+    RequestHandler handler_;
+    std::atomic<bool> stopped_ = false;
+    int wake_fd_ = -1;
+};
+
+// Нагрузочный клиент: открывает connections_count соединений, каждое из которых по очереди
+// отправляет все запросы из requests и дожидается ответа на каждый. Сводку времени ответа пишет в report
+void RunQueryClient(const std::string& socket_path, std::istream& requests, size_t connections_count,
+                    std::ostream& report);
+
+}  // namespace server
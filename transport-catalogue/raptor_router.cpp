@@ -0,0 +1,221 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace router {
+
+static constexpr double UNREACHED = std::numeric_limits<double>::infinity();
+static constexpr size_t NO_POSITION = std::numeric_limits<size_t>::max();
+
+RaptorRouter::RaptorRouter(const catalogue::TransportCatalogue &catalogue, const TransportRouter &transport_router)
+    : bus_wait_time_(transport_router.GetBusWaitTime())
+    , stops_(catalogue.GetStops())
+    , buses_(catalogue.GetBuses())
+{
+    std::sort(stops_.begin(), stops_.end());
+    std::sort(buses_.begin(), buses_.end());
+    stop_patterns_.resize(stops_.size());
+    stop_footpaths_.resize(stops_.size());
+
+    // Остановки у transport_router тоже упорядочены по имени, поэтому индексы совпадают
+    for (const auto& route : transport_router.GetRouteParams()){
+        if (route.IsWalk()){
+            stop_footpaths_[route.from_stop].push_back({route.to_stop, route.time});
+        }
+    }
+
+    const double koeff = 1 / (transport_router.GetBusVelocity() * SPEED_TRANSFORM_KOEFFICIENT);
+
+    for (size_t bus_index = 0; bus_index < buses_.size(); ++bus_index){
+        const auto& bus_info = catalogue.FindBus(buses_[bus_index]);
+        if (!bus_info || bus_info->stops.empty())
+            continue;
+
+        Pattern forward{bus_index, {}, {}};
+        forward.stops.reserve(bus_info->stops.size());
+        for (const auto stop : bus_info->stops){
+            forward.stops.push_back(*FindStop(stop->name));
+        }
+
+        std::vector<Pattern> bus_patterns;
+        if (bus_info->type == Linear){
+            Pattern backward{bus_index, {forward.stops.rbegin(), forward.stops.rend()}, {}};
+            bus_patterns.push_back(std::move(forward));
+            bus_patterns.push_back(std::move(backward));
+        } else {
+            bus_patterns.push_back(std::move(forward));
+        }
+
+        for (Pattern& pattern : bus_patterns){
+            pattern.segment_times.reserve(pattern.stops.size());
+            for (size_t i = 0; i + 1 < pattern.stops.size(); ++i){
+                pattern.segment_times.push_back(
+                            catalogue.GetDistanceBetweenStops(stops_[pattern.stops[i]], stops_[pattern.stops[i + 1]]) * koeff);
+            }
+            for (size_t position = 0; position < pattern.stops.size(); ++position){
+                stop_patterns_[pattern.stops[position]].emplace_back(patterns_.size(), position);
+            }
+            patterns_.push_back(std::move(pattern));
+        }
+    }
+}
+
+std::vector<RouteInfo> RaptorRouter::FindRoutes(std::string_view from_stop, std::string_view to_stop) const
+{
+    const auto from = FindStop(from_stop);
+    const auto to = FindStop(to_stop);
+    if (!from || !to){
+        return {};
+    }
+
+    const Label unreached{UNREACHED, Label::Source, 0, 0, 0, 0};
+
+    // best[s] — лучшее прибытие на остановку за все раунды. Прибытие в раунде сохраняется, только если
+    // оно лучше прежних и лучше уже найденного прибытия в конечную остановку, поэтому непустые метки
+    // конечной остановки по раундам и образуют множество Парето
+    std::vector<double> best(stops_.size(), UNREACHED);
+    std::vector<std::vector<Label>> rounds(1, std::vector<Label>(stops_.size(), unreached));
+    rounds[0][*from].arrival = 0;
+    best[*from] = 0;
+
+    // Раунд 0 — пешком от начальной остановки, без поездок
+    std::vector<size_t> marked_stops{*from};
+    RelaxFootpaths(marked_stops, rounds[0], best, *to);
+    std::vector<bool> is_marked(stops_.size(), false);
+    std::vector<size_t> first_marked(patterns_.size(), NO_POSITION);
+
+    // Каждый раунд добавляет одну поездку, поэтому раундов не больше, чем проходов
+    for (size_t round = 1; !marked_stops.empty() && round <= patterns_.size(); ++round){
+        // Садиться имеет смысл только на остановках, прибытие на которые улучшилось в прошлом раунде
+        std::fill(first_marked.begin(), first_marked.end(), NO_POSITION);
+        for (const size_t stop : marked_stops){
+            for (const auto& [pattern, position] : stop_patterns_[stop]){
+                first_marked[pattern] = std::min(first_marked[pattern], position);
+            }
+            is_marked[stop] = false;
+        }
+        marked_stops.clear();
+
+        const std::vector<double> previous = best;
+        rounds.emplace_back(stops_.size(), unreached);
+        std::vector<Label>& labels = rounds.back();
+
+        for (size_t pattern_index = 0; pattern_index < patterns_.size(); ++pattern_index){
+            if (first_marked[pattern_index] == NO_POSITION)
+                continue;
+
+            const Pattern& pattern = patterns_[pattern_index];
+            bool boarded = false;
+            size_t board_stop = 0;
+            double board_arrival = 0;
+            double ride_time = 0;
+            size_t span_count = 0;
+
+            for (size_t position = first_marked[pattern_index]; position < pattern.stops.size(); ++position){
+                const size_t stop = pattern.stops[position];
+
+                if (boarded){
+                    ride_time += pattern.segment_times[position - 1];
+                    ++span_count;
+                    const double arrival = board_arrival + (ride_time + bus_wait_time_);
+                    if (arrival < best[stop] && arrival < best[*to]){
+                        best[stop] = arrival;
+                        labels[stop] = {arrival, Label::Ride, pattern_index, board_stop, span_count, ride_time};
+                        if (!is_marked[stop]){
+                            is_marked[stop] = true;
+                            marked_stops.push_back(stop);
+                        }
+                    }
+                }
+
+                // Пересаживаемся на этот автобус здесь, если дальше так получится раньше
+                if (previous[stop] != UNREACHED && (!boarded || previous[stop] < board_arrival + ride_time)){
+                    boarded = true;
+                    board_stop = stop;
+                    board_arrival = previous[stop];
+                    ride_time = 0;
+                    span_count = 0;
+                }
+            }
+        }
+
+        RelaxFootpaths(marked_stops, labels, best, *to);
+    }
+
+    std::vector<RouteInfo> result;
+    for (size_t round = 0; round < rounds.size(); ++round){
+        if (rounds[round][*to].arrival != UNREACHED){
+            result.push_back(MakeRouteInfo(rounds, round, *to));
+        }
+    }
+    return result;
+}
+
+void RaptorRouter::RelaxFootpaths(std::vector<size_t>& improved, std::vector<Label>& labels, std::vector<double>& best,
+                                  size_t to) const
+{
+    // Переходы можно продолжать пешком, поэтому просматриваются и остановки, улучшенные здесь же.
+    // Остановка попадает в improved повторно, только если прибытие на неё снова улучшилось
+    for (size_t i = 0; i < improved.size(); ++i){
+        const size_t from = improved[i];
+        for (const Footpath& footpath : stop_footpaths_[from]){
+            const double arrival = best[from] + footpath.time;
+            if (arrival < best[footpath.to] && arrival < best[to]){
+                best[footpath.to] = arrival;
+                labels[footpath.to] = {arrival, Label::Walk, 0, from, 0, footpath.time};
+                improved.push_back(footpath.to);
+            }
+        }
+    }
+
+    std::sort(improved.begin(), improved.end());
+    improved.erase(std::unique(improved.begin(), improved.end()), improved.end());
+}
+
+std::optional<size_t> RaptorRouter::FindStop(std::string_view name) const
+{
+    const auto it = std::lower_bound(stops_.begin(), stops_.end(), name);
+    if (it == stops_.end() || *it != name){
+        return std::nullopt;
+    }
+    return std::distance(stops_.begin(), it);
+}
+
+RouteInfo RaptorRouter::MakeRouteInfo(const std::vector<std::vector<Label>>& rounds, size_t round, size_t to) const
+{
+    RouteInfo route_info = RouteInfo();
+    route_info.total_time = rounds[round][to].arrival;
+
+    // Лучшее прибытие не более чем за round поездок записано в последнем раунде, где оно улучшалось.
+    // Переход пешком начинается с остановки, прибытие на которую улучшилось в том же раунде
+    size_t stop = to;
+    while (true){
+        while (rounds[round][stop].arrival == UNREACHED){
+            --round;
+        }
+
+        const Label& label = rounds[round][stop];
+        if (label.kind == Label::Source){
+            break;
+        }
+        if (label.kind == Label::Walk){
+            route_info.items.push_front(
+                        RouteInfo::WalkInfo{stops_[label.board_stop], stops_[stop], label.ride_time});
+            stop = label.board_stop;
+            continue;
+        }
+
+        // Маршрут восстанавливается с конца: поездка предшествует в списке ожиданию перед ней
+        route_info.items.push_front(
+                    RouteInfo::BusInfo{buses_[patterns_[label.pattern].bus], label.span_count, label.ride_time});
+        route_info.items.push_front(
+                    RouteInfo::StopInfo{stops_[label.board_stop], bus_wait_time_});
+
+        stop = label.board_stop;
+        --round;
+    }
+    return route_info;
+}
+
+} // namespace router
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace router {
+
+// Поиск маршрутов по раундам (RAPTOR): раунд k находит самые быстрые поездки не более чем на k автобусах.
+// Работает прямо с последовательностями остановок маршрутов, без рёбер между всеми парами остановок
+// маршрута, и за один проход находит все оптимальные по Парето сочетания числа пересадок и времени.
+// Модель та же, что у TransportRouter: ожидание автобуса при каждой посадке, время в пути по расстояниям
+// и те же переходы пешком, которые пересадками не считаются
+class RaptorRouter {
+public:
+    // Настройки и переходы пешком берутся из transport_router, построенного по тому же справочнику
+    RaptorRouter(const catalogue::TransportCatalogue& catalogue, const TransportRouter& transport_router);
+
+    ///[\brief] Оптимальные по Парето маршруты в порядке возрастания числа пересадок: первый содержит
+    /// меньше всего пересадок, последний — самый быстрый. Пуст, если маршрута нет
+    std::vector<RouteInfo> FindRoutes(std::string_view from_stop, std::string_view to_stop) const;
+
+private:
+    // Проезд автобуса по остановкам в одном направлении. Некольцевой маршрут даёт два прохода
+    struct Pattern {
+        size_t bus;
+        std::vector<size_t> stops;
+        std::vector<double> segment_times;  ///< время в пути от stops[i] до stops[i + 1]
+    };
+
+    // Переход пешком от остановки
+    struct Footpath {
+        size_t to;
+        double time;
+    };
+
+    // Лучшее прибытие на остановку в раунде и последняя поездка или переход, которыми оно достигнуто
+    struct Label {
+        enum Kind {
+            Source,
+            Ride,
+            Walk,
+        };
+
+        double arrival;
+        Kind kind;
+        size_t pattern;
+        size_t board_stop;      ///< остановка посадки или начала перехода
+        size_t span_count;
+        double ride_time;
+    };
+
+    std::optional<size_t> FindStop(std::string_view name) const;
+    // Продолжает пешком прибытия на остановки из improved. Улучшенные остановки добавляются в improved
+    void RelaxFootpaths(std::vector<size_t>& improved, std::vector<Label>& labels, std::vector<double>& best,
+                        size_t to) const;
+    RouteInfo MakeRouteInfo(const std::vector<std::vector<Label>>& rounds, size_t round, size_t to) const;
+
+    double bus_wait_time_;
+    std::vector<std::string> stops_;
+    std::vector<std::string> buses_;
+    std::vector<Pattern> patterns_;
+    // Для каждой остановки: проходы через неё и её положение в проходе
+    std::vector<std::vector<std::pair<size_t, size_t>>> stop_patterns_;
+    std::vector<std::vector<Footpath>> stop_footpaths_;
+};
+
+} // namespace router
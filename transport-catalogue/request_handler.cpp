@@ -3,7 +3,9 @@
 #include "serialization.h"
 
 #include <fstream>
+#include <future>
 #include <sstream>
+#include <stdexcept>
 /*
  * Здесь можно было бы разместить код обработчика запросов к базе, содержащего логику, которую не
  * хотелось бы помещать ни в transport_catalogue, ни в json reader.
@@ -29,14 +31,54 @@ void RequestHandler::AddDistanceBetweenStops(const std::string &from, const std:
 
 std::optional<BusStat> RequestHandler::GetBusStat(const std::string_view &bus_name) const
 {
+    LoadCatalogue();
     return catalogue_.GetBusInfo(bus_name);
 }
 
 const std::optional<StopStat> RequestHandler::GetStopStat(const std::string_view &stop_name) const
 {
+    LoadCatalogue();
     return catalogue_.GetStopInfo(stop_name);
 }
 
+std::vector<NearbyStop> RequestHandler::GetNearestStops(const Coordinates &center, size_t count) const
+{
+    const StopIndex& stops = GetStopIndex();
+    std::vector<NearbyStop> result;
+    for (const auto& [index, distance] : stops.index.FindNearest(center, count)) {
+        result.push_back({stops.names[index], distance});
+    }
+    return result;
+}
+
+std::vector<NearbyStop> RequestHandler::GetStopsInRadius(const Coordinates &center, double radius) const
+{
+    const StopIndex& stops = GetStopIndex();
+    std::vector<NearbyStop> result;
+    for (const auto& [index, distance] : stops.index.FindInRadius(center, radius)) {
+        result.push_back({stops.names[index], distance});
+    }
+    return result;
+}
+
+const RequestHandler::StopIndex& RequestHandler::GetStopIndex() const
+{
+    LoadCatalogue();
+    std::call_once(stop_index_built_, [this] {
+        auto stops = std::make_unique<StopIndex>();
+        stops->names = catalogue_.GetStops();
+
+        std::vector<Coordinates> coordinates;
+        coordinates.reserve(stops->names.size());
+        for (const std::string& name : stops->names) {
+            coordinates.push_back(catalogue_.GetStopCoordinates(name).value_or(Coordinates{0, 0}));
+        }
+        stops->index = geo::SpatialIndex(coordinates);
+        stop_index_ = std::move(stops);
+    });
+    return *stop_index_;
+}
+
 void RequestHandler::SetRendererSettings(const renderer::MapRenderSettings &settings)
 {
     renderer_.SetSettings(settings);
@@ -44,45 +86,124 @@ void RequestHandler::SetRendererSettings(const renderer::MapRenderSettings &sett
 
 void RequestHandler::RenderMap(std::ostream &stream) const
 {
+    LoadRenderer();
+    // В базе прежнего формата карта не вычислена заранее и строится по справочнику
+    if (!renderer_.GetLayout()) {
+        LoadCatalogue();
+    }
     renderer_.RenderCatalogue(catalogue_, stream);
 }
 
-void RequestHandler::SetRouterSettings(const int bus_wait_time, const int bus_velocity)
+void RequestHandler::SetRouterSettings(const int bus_wait_time, const int bus_velocity,
+                                       const double walk_radius, const double walking_velocity)
 {
     router_.SetBusWaitTime(bus_wait_time).SetBusVelocity(bus_velocity);
+    router_.SetWalkRadius(walk_radius).SetWalkingVelocity(walking_velocity);
     router_.RouteCatalogue(catalogue_);
 }
 
 std::optional<RouteInfo> RequestHandler::MakeRoute(const std::string &from_stop, const std::string &to_stop) const
 {
+    LoadRouter();
     return router_.MakeRoute(from_stop, to_stop);
 }
 
+std::vector<RouteInfo> RequestHandler::MakeParetoRoutes(const std::string &from_stop, const std::string &to_stop) const
+{
+    return GetRaptorRouter().FindRoutes(from_stop, to_stop);
+}
+
+const router::RaptorRouter& RequestHandler::GetRaptorRouter() const
+{
+    // Нужны маршруты справочника и настройки маршрутизации
+    LoadCatalogue();
+    LoadRouter();
+    std::call_once(raptor_router_built_, [this] {
+        raptor_router_ = std::make_unique<router::RaptorRouter>(catalogue_, router_);
+    });
+    return *raptor_router_;
+}
+
 void RequestHandler::Serialize(const std::string& path)
 {
     std::ofstream stream(path, std::ofstream::out | std::ofstream::trunc | std::ostream::binary);
 
-    transport_catalogue_serialize::Catalogue data;
+    // Настройки отрисовки фиксируются при создании базы, поэтому карту можно вычислить заранее
+    renderer_.SetLayout(renderer_.MakeLayout(catalogue_));
 
-    serialize::Serialize(data, catalogue_);
-    serialize::Serialize(data, renderer_);
-    serialize::Serialize(data, router_);
+    std::array<transport_catalogue_serialize::Catalogue, serialize::SECTIONS_COUNT> sections;
+    serialize::SerializeCatalogue(sections[static_cast<size_t>(serialize::Section::Catalogue)], catalogue_);
+    serialize::SerializeRenderer(sections[static_cast<size_t>(serialize::Section::Render)], renderer_);
+    serialize::SerializeRouter(sections[static_cast<size_t>(serialize::Section::Routing)], router_);
 
-    data.SerializeToOstream(&stream);
+    serialize::WriteBase(stream, sections);
 
     stream.close();
 }
 
-void RequestHandler::Deserialize(const std::string& path)
+void RequestHandler::Deserialize(const std::string& path, BaseLoading loading)
+{
+    // Оглавление читается сразу: недоступная база не должна подменить рабочую при перезагрузке
+    try {
+        base_ = std::make_shared<const serialize::BaseReader>(path);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("RequestHandler: failed to read base '" + path + "': " + e.what());
+    }
+
+    if (loading == BaseLoading::Eager) {
+        // Разделы независимы и разбираются в отдельных потоках
+        auto renderer_loaded = std::async(std::launch::async, [this] { LoadRenderer(); });
+        LoadRouter();
+        renderer_loaded.get();
+    }
+}
+
+void RequestHandler::Warm() const
 {
-    std::ifstream stream(path, std::ifstream::in | std::ostream::binary);
+    LoadRouter();
+    // Маршрутизатор графа меняет только граф, а RAPTOR и индекс остановок его не читают,
+    // поэтому все три строятся одновременно
+    auto graph_router_built = std::async(std::launch::async, [this] { router_.BuildRouter(); });
+    auto raptor_router_built = std::async(std::launch::async, [this] { GetRaptorRouter(); });
+    GetStopIndex();
+    graph_router_built.get();
+    raptor_router_built.get();
+}
 
-    transport_catalogue_serialize::Catalogue data;
-    data.ParseFromIstream(&stream);
+void RequestHandler::LoadCatalogue() const
+{
+    if (!base_) {
+        return;
+    }
+    std::call_once(catalogue_loaded_, [this] {
+        serialize::DeserializeCatalogue(*base_->ReadSection(serialize::Section::Catalogue), catalogue_);
+    });
+}
 
-    serialize::Deserialize(data, catalogue_);
-    serialize::Deserialize(data, renderer_);
-    serialize::Deserialize(data, router_);
+void RequestHandler::LoadRenderer() const
+{
+    if (!base_) {
+        return;
+    }
+    std::call_once(renderer_loaded_, [this] {
+        serialize::DeserializeRenderer(*base_->ReadSection(serialize::Section::Render), renderer_);
+    });
+}
 
-    stream.close();
+void RequestHandler::LoadRouter() const
+{
+    if (!base_) {
+        return;
+    }
+    std::call_once(router_loaded_, [this] {
+        // Граф строится по индексам остановок и не зависит от справочника, поэтому восстанавливается
+        // одновременно с ним. Имена, на которые ссылаются индексы, берутся из справочника
+        auto graph_loaded = std::async(std::launch::async, [this] {
+            serialize::DeserializeRouter(*base_->ReadSection(serialize::Section::Routing), router_);
+        });
+        LoadCatalogue();
+        graph_loaded.get();
+        router_.SetStops(catalogue_.GetStops());
+        router_.SetBuses(catalogue_.GetBuses());
+    });
 }
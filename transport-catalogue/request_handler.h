@@ -1,8 +1,12 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <unordered_set>
 
 #include "map_renderer.h"
+#include "raptor_router.h"
+#include "spatial_index.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
@@ -27,6 +31,16 @@ using renderer::MapRenderSettings;
 using router::TransportRouter;
 using router::RouteInfo;
 
+namespace serialize {
+class BaseReader;
+}
+
+// Когда загружаются разделы базы при Deserialize
+enum class BaseLoading {
+    Lazy,   ///< при первом запросе, которому нужен раздел
+    Eager,  ///< все сразу
+};
+
 class RequestHandler {
 public:
     RequestHandler(catalogue::TransportCatalogue& db, renderer::MapRenderer& renderer, router::TransportRouter& router);
@@ -42,19 +56,55 @@ public:
     // Возвращает маршруты, проходящие через остановку
     const std::optional<StopStat> GetStopStat(const std::string_view& stop_name) const;
 
+    // Не более count ближайших к точке остановок в порядке удаления (запрос NearestStops)
+    std::vector<NearbyStop> GetNearestStops(const Coordinates& center, size_t count) const;
+    // Остановки не дальше radius метров от точки в порядке удаления (запрос StopsInRadius)
+    std::vector<NearbyStop> GetStopsInRadius(const Coordinates& center, double radius) const;
+
     void SetRendererSettings(const MapRenderSettings& settings);
     void RenderMap(std::ostream &stream) const;
 
-    void SetRouterSettings(const int bus_wait_time, const int bus_velocity);
+    // Переходы пешком между остановками строятся, если заданы радиус (м) и скорость пешехода (км/ч)
+    void SetRouterSettings(const int bus_wait_time, const int bus_velocity,
+                           const double walk_radius = 0, const double walking_velocity = 0);
     std::optional<RouteInfo> MakeRoute(const std::string& from_stop, const std::string &to_stop) const;
+    // Оптимальные по Парето маршруты: от наименьшего числа пересадок до наименьшего времени в пути
+    std::vector<RouteInfo> MakeParetoRoutes(const std::string& from_stop, const std::string &to_stop) const;
 
     void Serialize(const std::string& path);
-    void Deserialize(const std::string& path);
+    // Открывает базу. Запросы Bus и Stop не загружают разделы отрисовки и маршрутизации
+    void Deserialize(const std::string& path, BaseLoading loading = BaseLoading::Lazy);
+    // Строит маршрутизаторы и индекс остановок, которые иначе строятся при первом запросе к ним
+    void Warm() const;
 
 private:
+    void LoadCatalogue() const;
+    void LoadRenderer() const;
+    void LoadRouter() const;
+
     TransportCatalogue& catalogue_;
     MapRenderer& renderer_;
     TransportRouter& router_;
+
+    // Открытая база; пуста, если справочник заполнен запросами на создание базы
+    std::shared_ptr<const serialize::BaseReader> base_;
+    mutable std::once_flag catalogue_loaded_;
+    mutable std::once_flag renderer_loaded_;
+    mutable std::once_flag router_loaded_;
+
+    // Строится по справочнику при первом запросе оптимальных по Парето маршрутов
+    const router::RaptorRouter& GetRaptorRouter() const;
+    mutable std::unique_ptr<router::RaptorRouter> raptor_router_;
+    mutable std::once_flag raptor_router_built_;
+
+    // Строится по координатам остановок при первом поиске остановок рядом с точкой
+    struct StopIndex {
+        std::vector<std::string> names;
+        geo::SpatialIndex index;
+    };
+    const StopIndex& GetStopIndex() const;
+    mutable std::unique_ptr<StopIndex> stop_index_;
+    mutable std::once_flag stop_index_built_;
 };
 
 template<typename Container>
@@ -14,12 +14,15 @@
 
 namespace graph {
 
-template <typename Weight>
+template <typename Weight, typename Id = size_t>
 class Router {
 private:
-    using Graph = DirectedWeightedGraph<Weight>;
+    using Graph = DirectedWeightedGraph<Weight, Id>;
+    using VertexId = typename Graph::VertexId;
+    using EdgeId = typename Graph::EdgeId;
 
 public:
+    // Граф должен быть заморожен (DirectedWeightedGraph::Freeze)
     explicit Router(const Graph& graph);
 
     struct RouteInfo {
@@ -40,14 +43,13 @@ private:
         const size_t vertex_count = graph.GetVertexCount();
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
             routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                const auto& edge = graph.GetEdge(edge_id);
+            for (const auto& edge : graph.GetOutgoingEdges(vertex)) {
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
                 auto& route_internal_data = routes_internal_data_[vertex][edge.to];
                 if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                    route_internal_data = RouteInternalData{edge.weight, edge.id};
                 }
             }
         }
@@ -80,12 +82,15 @@ private:
     RoutesInternalData routes_internal_data_;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+template <typename Weight, typename Id>
+Router<Weight, Id>::Router(const Graph& graph)
     : graph_(graph)
     , routes_internal_data_(graph.GetVertexCount(),
                             std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
 {
+    if (!graph.IsFrozen()) {
+        throw std::invalid_argument("Router requires a frozen graph");
+    }
     InitializeRoutesInternalData(graph);
 
     const size_t vertex_count = graph.GetVertexCount();
@@ -94,9 +99,9 @@ Router<Weight>::Router(const Graph& graph)
     }
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                             VertexId to) const {
+template <typename Weight, typename Id>
+std::optional<typename Router<Weight, Id>::RouteInfo> Router<Weight, Id>::BuildRoute(VertexId from,
+                                                                                     VertexId to) const {
     const auto& route_internal_data = routes_internal_data_.at(from).at(to);
     if (!route_internal_data) {
         return std::nullopt;
@@ -1,4 +1,8 @@
+#include <cmath>
+#include <cstdint>
 #include <fstream>
+#include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
 #include "serialization.h"
@@ -6,6 +10,18 @@
 #include <map_renderer.pb.h>
 #include <svg.pb.h>
 
+// Координаты хранятся целым числом миллиардных долей градуса: координаты с не более чем
+// девятью знаками после запятой восстанавливаются без потерь
+static constexpr double DEGREE_SCALE = 1e9;
+
+int64_t EncodeDegrees(double degrees){
+    return std::llround(degrees * DEGREE_SCALE);
+}
+
+double DecodeDegrees(int64_t value){
+    return static_cast<double>(value) / DEGREE_SCALE;
+}
+
 svg_serialize::Color SerializeColor(const svg::Color& other){
     svg_serialize::Color color;
     if (std::holds_alternative<std::string>(other)){
@@ -55,27 +71,31 @@ void serialize::SerializeCatalogue(transport_catalogue_serialize::Catalogue& cat
 {
     const auto& t_stops = t_catalogue.GetStops();
 
+    // Остановки в маршрутах и расстояниях задаются индексами в списке остановок
+    std::unordered_map<std::string_view, uint32_t> stop_indices;
+    stop_indices.reserve(t_stops.size());
+
+    int64_t prev_latitude = 0;
+    int64_t prev_longitude = 0;
     for (const std::string& t_stop : t_stops){
-        auto stop = catalogue.add_stops();
-        stop->set_name(t_stop);
+        stop_indices.emplace(t_stop, static_cast<uint32_t>(stop_indices.size()));
+        catalogue.add_stops()->set_name(t_stop);
 
         // Координаты остановки
         const auto& t_stop_coordinates = t_catalogue.GetStopCoordinates(t_stop);
-        if (t_stop_coordinates){
-            stop->mutable_coordinates()->set_latitude(t_stop_coordinates->lat);
-            stop->mutable_coordinates()->set_longitude(t_stop_coordinates->lng);
-        }
-
-        // Дистанция между остановками
-        for (const std::string& t_stop_to : t_stops){
-            auto t_distance = t_catalogue.GetDistanceBetweenStops(t_stop, t_stop_to);
-            if (t_distance == 0 || t_distance > catalogue::TransportCatalogue::maxRouteDistance)
-                continue;
+        const int64_t latitude = t_stop_coordinates ? EncodeDegrees(t_stop_coordinates->lat) : 0;
+        const int64_t longitude = t_stop_coordinates ? EncodeDegrees(t_stop_coordinates->lng) : 0;
+        catalogue.add_latitudes(latitude - prev_latitude);
+        catalogue.add_longitudes(longitude - prev_longitude);
+        prev_latitude = latitude;
+        prev_longitude = longitude;
+    }
 
-            auto distance = stop->add_distance();
-            distance->set_length(t_distance);
-            distance->set_stop(t_stop_to);
-        }
+    // Дистанция между остановками
+    for (const auto& [t_from, t_to, t_distance] : t_catalogue.GetDistances()){
+        auto stop = catalogue.mutable_stops(stop_indices.at(t_from));
+        stop->add_distance_stops(stop_indices.at(t_to));
+        stop->add_distance_meters(t_distance);
     }
 
     const auto& t_buses = t_catalogue.GetBuses();
@@ -86,7 +106,7 @@ void serialize::SerializeCatalogue(transport_catalogue_serialize::Catalogue& cat
         auto t_bus_stops = t_catalogue.GetBusStops(t_bus);
         if (t_bus_stops){
             for(const std::string& t_bus_stop : *t_bus_stops){
-                bus->add_stops(t_bus_stop);
+                bus->add_stop_indices(stop_indices.at(t_bus_stop));
             }
         }
     }
@@ -119,6 +139,27 @@ void serialize::SerializeRenderer(transport_catalogue_serialize::Catalogue& tc,
     for (const svg::Color& r_color : r_settings.color_palette){
         *settings->add_color_palette() = SerializeColor(r_color);
     }
+
+    // Заранее вычисленная карта избавляет от проецирования и сортировки при обработке запросов
+    const auto& r_layout = t_renderer.GetLayout();
+    if (r_layout){
+        auto layout = tc.mutable_map_layout();
+        for (const auto& r_stop : r_layout->stops){
+            auto stop = layout->add_stops();
+            stop->set_name(r_stop.title);
+            stop->mutable_position()->set_x(r_stop.position.x);
+            stop->mutable_position()->set_y(r_stop.position.y);
+        }
+        for (const auto& r_bus : r_layout->buses){
+            auto bus = layout->add_buses();
+            bus->set_name(r_bus.title);
+            bus->set_is_linear(r_bus.is_linear);
+            bus->set_color_index(r_bus.color_index);
+            for (const size_t r_stop_index : r_bus.stops){
+                bus->add_stops(r_stop_index);
+            }
+        }
+    }
 }
 
 void serialize::SerializeRouter(transport_catalogue_serialize::Catalogue& tc, const router::TransportRouter &t_router)
@@ -127,32 +168,24 @@ void serialize::SerializeRouter(transport_catalogue_serialize::Catalogue& tc, co
 
     settings->set_wait_time(t_router.GetBusWaitTime());
     settings->set_velocity(t_router.GetBusVelocity());
-
-    const auto& t_buses = t_router.GetBuses();
-    const auto& t_stops = t_router.GetStops();
-
-    for(size_t i = 0; i < t_router.GetRouteParamsCount(); ++i){
-        auto route = settings->add_routes();
-
-        const auto& t_route_param = t_router.GetRouteParams(i);
-
-        route->set_index(i);
-        route->set_from(std::distance(t_stops.begin(), std::find(t_stops.begin(), t_stops.end(), t_route_param.from_stop)));
-        route->set_to(std::distance(t_stops.begin(), std::find(t_stops.begin(), t_stops.end(), t_route_param.to_stop)));
-        route->set_bus(std::distance(t_buses.begin(), std::find(t_buses.begin(), t_buses.end(), t_route_param.bus)));
-        route->set_span_count(t_route_param.span_count);
-        route->set_time(t_route_param.time);
-    }
-
-    auto graph = tc.mutable_graph();
-    auto t_graph = t_router.GetGraph();
-    for(size_t i = 0; i < t_graph.GetEdgeCount(); ++i){
-        auto edge = graph->add_edges();
-        const auto& t_edge = t_graph.GetEdge(i);
-        edge->set_index(i);
-        edge->set_from(t_edge.from);
-        edge->set_to(t_edge.to);
-        edge->set_weight(t_edge.weight);
+    settings->set_stops_count(t_router.GetStops().size());
+    settings->set_walk_radius(t_router.GetWalkRadius());
+    settings->set_walking_velocity(t_router.GetWalkingVelocity());
+
+    const auto& t_routes = t_router.GetRouteParams();
+    const int routes_size = static_cast<int>(t_routes.size());
+    settings->mutable_route_from()->Reserve(routes_size);
+    settings->mutable_route_to()->Reserve(routes_size);
+    settings->mutable_route_bus()->Reserve(routes_size);
+    settings->mutable_route_span_count()->Reserve(routes_size);
+    settings->mutable_route_time()->Reserve(routes_size);
+
+    for (const auto& t_route : t_routes){
+        settings->add_route_from(t_route.from_stop);
+        settings->add_route_to(t_route.to_stop);
+        settings->add_route_bus(t_route.bus);
+        settings->add_route_span_count(t_route.span_count);
+        settings->add_route_time(t_route.time);
     }
 }
 
@@ -161,42 +194,64 @@ void serialize::DeserializeCatalogue(const transport_catalogue_serialize::Catalo
     size_t buses_size = catalogue.buses_size();
     size_t stops_size = catalogue.stops_size();
 
-    std::vector<std::string_view> buses(buses_size);
-    std::vector<std::string_view> stops(stops_size);
+    size_t distances_size = 0;
+    for (const auto& stop : catalogue.stops()){
+        distances_size += stop.distance_stops_size() + stop.distance_size();
+    }
+    t_catalogue.Reserve(stops_size, buses_size, distances_size);
 
+    // Базы прежнего формата хранят координаты в самих остановках, а остановки маршрутов
+    // и расстояний — именами
+    const bool packed_coordinates = catalogue.latitudes_size() == static_cast<int>(stops_size)
+            && catalogue.longitudes_size() == static_cast<int>(stops_size);
+
+    // Номера остановок в справочнике совпадают с индексами в базе, если справочник был пуст
+    const size_t first_stop = t_catalogue.GetStopsCount();
+
+    int64_t latitude = 0;
+    int64_t longitude = 0;
     for (size_t i = 0; i < stops_size; ++i){
         const auto& stop = catalogue.stops(i);
-        stops[i] = stop.name();
-        t_catalogue.AddStop(std::string(stop.name()),
-                            {stop.coordinates().latitude(),
-                             stop.coordinates().longitude()});
+        geo::Coordinates coordinates{stop.coordinates().latitude(), stop.coordinates().longitude()};
+        if (packed_coordinates){
+            latitude += catalogue.latitudes(i);
+            longitude += catalogue.longitudes(i);
+            coordinates = {DecodeDegrees(latitude), DecodeDegrees(longitude)};
+        }
+        t_catalogue.AddStop(stop.name(), coordinates);
     }
 
     for (size_t i = 0; i < stops_size; ++i){
         const auto& stop = catalogue.stops(i);
-        for (size_t d = 0; d < stop.distance_size(); ++d){
-            const auto& distance = stop.distance(d);
-            if (!distance.IsInitialized())
-                continue;
-            t_catalogue.AddDistance(stop.name(),
-                                    distance.stop(),
-                                    distance.length());
+        if (stop.distance_meters_size() != stop.distance_stops_size()){
+            throw std::runtime_error("Corrupted road distances of stop " + stop.name());
+        }
+        for (int d = 0; d < stop.distance_stops_size(); ++d){
+            if (stop.distance_stops(d) >= stops_size){
+                throw std::runtime_error("Corrupted road distances of stop " + stop.name());
+            }
+            t_catalogue.AddDistance(first_stop + i, first_stop + stop.distance_stops(d), stop.distance_meters(d));
+        }
+        for (const auto& distance : stop.distance()){
+            t_catalogue.AddDistance(stop.name(), distance.stop(), distance.length());
         }
     }
 
+    std::vector<size_t> bus_stops;
     for (size_t i = 0; i < buses_size; ++i){
         const auto& bus = catalogue.buses(i);
-        buses[i] = bus.name();
+        const RouteType type = bus.is_roundtrip() ? RouteType::Roundtrip : RouteType::Linear;
 
-        size_t bus_stops_size = bus.stops_size();
-        std::vector<std::string> bus_stops(bus_stops_size);
-        for (size_t i = 0; i < bus_stops_size; ++i){
-            bus_stops[i] = bus.stops(i);
+        if (bus.stops_size() > 0){
+            t_catalogue.AddBus(bus.name(), type, bus.stops());
+            continue;
         }
 
-        t_catalogue.AddBus(bus.name(),
-                           bus.is_roundtrip() ? RouteType::Roundtrip : RouteType::Linear,
-                           bus_stops);
+        bus_stops.clear();
+        for (const uint32_t stop_index : bus.stop_indices()){
+            bus_stops.push_back(first_stop + stop_index);
+        }
+        t_catalogue.AddBusByIndices(bus.name(), type, bus_stops);
     }
 }
 
@@ -233,51 +288,161 @@ void serialize::DeserializeRenderer(const transport_catalogue_serialize::Catalog
     }
 
     t_renderer.SetSettings(r_settings);
+
+    // В базах без сохранённой карты она будет вычислена по справочнику при первом запросе
+    if (!tc.has_map_layout())
+        return;
+
+    const auto& layout = tc.map_layout();
+    renderer::MapLayout r_layout;
+
+    size_t stops_size = layout.stops_size();
+    r_layout.stops.resize(stops_size);
+    for (size_t i = 0; i < stops_size; ++i){
+        const auto& stop = layout.stops(i);
+        r_layout.stops[i] = {stop.name(),
+                             svg::Point{stop.position().x(), stop.position().y()}};
+    }
+
+    size_t buses_size = layout.buses_size();
+    r_layout.buses.resize(buses_size);
+    for (size_t i = 0; i < buses_size; ++i){
+        const auto& bus = layout.buses(i);
+        r_layout.buses[i] = {bus.name(),
+                             std::vector<size_t>(bus.stops().begin(), bus.stops().end()),
+                             bus.is_linear(),
+                             bus.color_index()};
+    }
+
+    t_renderer.SetLayout(std::move(r_layout));
 }
 
 void serialize::DeserializeRouter(const transport_catalogue_serialize::Catalogue& tc, router::TransportRouter &t_router)
 {
-    auto settings = tc.router();
+    const auto& settings = tc.router();
 
-    size_t buses_size = tc.buses_size();
-    size_t stops_size = tc.stops_size();
+    // В базе прежнего формата число вершин не записано, но сам раздел содержит остановки
+    const size_t stops_size = settings.stops_count() != 0 ? settings.stops_count() : tc.stops_size();
 
-    std::vector<std::string> buses(buses_size);
-    std::vector<std::string> stops(stops_size);
+    t_router.SetBusWaitTime(settings.wait_time());
+    t_router.SetBusVelocity(settings.velocity());
+    t_router.SetWalkRadius(settings.walk_radius());
+    t_router.SetWalkingVelocity(settings.walking_velocity());
 
-    for (size_t i = 0; i < buses_size; ++i){
-        buses[i] = tc.buses(i).name();
+    t_router.GetGraph() = router::TransportRouter::Graph(stops_size);
+
+    // Поездки прежнего формата записаны по порядку рёбер, а рёбра графа совпадают с ними
+    for (const auto& route : settings.routes()){
+        t_router.AddRoute({route.from(), route.to(), route.bus(), route.span_count(), route.time()});
     }
 
-    for (size_t i = 0; i < stops_size; ++i){
-        stops[i] = tc.stops(i).name();
+    const int routes_size = settings.route_from_size();
+    for (int i = 0; i < routes_size; ++i){
+        t_router.AddRoute({settings.route_from(i),
+                           settings.route_to(i),
+                           settings.route_bus(i),
+                           settings.route_span_count(i),
+                           settings.route_time(i)});
     }
+}
 
-    t_router.SetBuses(std::move(buses));
-    t_router.SetStops(std::move(stops));
+// Файл базы начинается с сигнатуры, за которой следуют длина оглавления и само оглавление.
+// Первый байт прежнего формата — тег поля сообщения Catalogue, сигнатура с ним не совпадает
+static constexpr std::string_view BASE_SIGNATURE = "TCBASE01";
+static constexpr size_t INDEX_LENGTH_SIZE = 4;
 
-    t_router.SetBusWaitTime(settings.wait_time());
-    t_router.SetBusVelocity(settings.velocity());
+void serialize::WriteBase(std::ostream& stream, const std::array<transport_catalogue_serialize::Catalogue, SECTIONS_COUNT>& sections)
+{
+    std::array<std::string, SECTIONS_COUNT> blobs;
+    transport_catalogue_serialize::SectionIndex index;
+    uint64_t offset = 0;
+    for (size_t i = 0; i < SECTIONS_COUNT; ++i){
+        sections[i].SerializeToString(&blobs[i]);
+        index.add_offsets(offset);
+        index.add_sizes(blobs[i].size());
+        offset += blobs[i].size();
+    }
+
+    const std::string header = index.SerializeAsString();
+    char length[INDEX_LENGTH_SIZE];
+    for (size_t i = 0; i < INDEX_LENGTH_SIZE; ++i){
+        length[i] = static_cast<char>((header.size() >> (8 * i)) & 0xFF);
+    }
+
+    stream.write(BASE_SIGNATURE.data(), BASE_SIGNATURE.size());
+    stream.write(length, INDEX_LENGTH_SIZE);
+    stream.write(header.data(), header.size());
+    for (const std::string& blob : blobs){
+        stream.write(blob.data(), blob.size());
+    }
+}
 
-    size_t routes_size = settings.routes_size();
-    for (size_t i = 0; i < routes_size; ++i){
-        auto route = settings.routes(i);
-        t_router.SetRouteParams(route.index(),
-                                {t_router.GetStops().at(route.from()),
-                                 t_router.GetStops().at(route.to()),
-                                 t_router.GetBuses().at(route.bus()),
-                                 route.span_count(),
-                                 route.time()});
+serialize::BaseReader::BaseReader(std::string path)
+    : path_(std::move(path))
+{
+    std::ifstream input(path_, std::ios::binary);
+    if (!input){
+        throw std::runtime_error("Cannot open base file " + path_);
     }
 
-    auto graph = tc.graph();
-    auto t_graph = graph::DirectedWeightedGraph<double>(t_router.GetStops().size());
-    for (size_t i = 0; i < graph.edges_size(); ++i){
-        auto edge = graph.edges(i);
-        t_graph.AddEdge({edge.from(),
-                         edge.to(),
-                         edge.weight()});
+    char signature[BASE_SIGNATURE.size()] = {};
+    input.read(signature, BASE_SIGNATURE.size());
+    if (!input || std::string_view(signature, BASE_SIGNATURE.size()) != BASE_SIGNATURE){
+        // Прежний формат: одно сообщение на весь файл
+        input.clear();
+        input.seekg(0);
+        auto whole = std::make_shared<transport_catalogue_serialize::Catalogue>();
+        if (!whole->ParseFromIstream(&input)){
+            throw std::runtime_error("Cannot parse base file " + path_);
+        }
+        whole_ = std::move(whole);
+        return;
     }
 
-    t_router.GetGraph() = t_graph;
+    unsigned char length[INDEX_LENGTH_SIZE] = {};
+    input.read(reinterpret_cast<char*>(length), INDEX_LENGTH_SIZE);
+    uint32_t header_size = 0;
+    for (size_t i = 0; i < INDEX_LENGTH_SIZE; ++i){
+        header_size |= static_cast<uint32_t>(length[i]) << (8 * i);
+    }
+
+    std::string header(header_size, '\0');
+    input.read(header.data(), header_size);
+    transport_catalogue_serialize::SectionIndex index;
+    if (!input || !index.ParseFromString(header)
+            || index.offsets_size() != static_cast<int>(SECTIONS_COUNT)
+            || index.sizes_size() != static_cast<int>(SECTIONS_COUNT)){
+        throw std::runtime_error("Cannot parse base file index " + path_);
+    }
+
+    // Обрезанный файл обнаруживается при открытии, а не при первом запросе к разделу
+    const uint64_t data_begin = BASE_SIGNATURE.size() + INDEX_LENGTH_SIZE + header_size;
+    input.seekg(0, std::ios::end);
+    const uint64_t file_size = static_cast<uint64_t>(input.tellg());
+    for (size_t i = 0; i < SECTIONS_COUNT; ++i){
+        const uint64_t offset = data_begin + index.offsets(static_cast<int>(i));
+        const uint64_t size = index.sizes(static_cast<int>(i));
+        if (offset + size > file_size){
+            throw std::runtime_error("Base file is truncated " + path_);
+        }
+        sections_[i].resize(size);
+        input.seekg(static_cast<std::streamoff>(offset));
+        input.read(sections_[i].data(), static_cast<std::streamsize>(size));
+        if (!input){
+            throw std::runtime_error("Cannot read section of base file " + path_);
+        }
+    }
+}
+
+std::shared_ptr<const transport_catalogue_serialize::Catalogue> serialize::BaseReader::ReadSection(Section section) const
+{
+    if (whole_){
+        return whole_;
+    }
+
+    auto result = std::make_shared<transport_catalogue_serialize::Catalogue>();
+    if (!result->ParseFromString(sections_[static_cast<size_t>(section)])){
+        throw std::runtime_error("Cannot parse section of base file " + path_);
+    }
+    return result;
 }
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <stdlib.h>
+#include <array>
+#include <memory>
+#include <string>
 #include <string_view>
 
 #include "transport_catalogue.h"
@@ -17,6 +20,38 @@ void SerializeRouter(transport_catalogue_serialize::Catalogue &Catalogue, const
 
 void DeserializeCatalogue(const transport_catalogue_serialize::Catalogue &Catalogue, catalogue::TransportCatalogue& t_catalogue);
 void DeserializeRenderer(const transport_catalogue_serialize::Catalogue &Catalogue, renderer::MapRenderer& t_renderer);
+// Восстанавливает настройки и граф. Справочник не нужен, поэтому может выполняться одновременно
+// с DeserializeCatalogue; имена остановок и маршрутов задаются по справочнику отдельно
 void DeserializeRouter(const transport_catalogue_serialize::Catalogue &Catalogue, router::TransportRouter& t_router);
 
+// Разделы файла базы, загружаемые независимо друг от друга
+enum class Section {
+    Catalogue,  ///< остановки, маршруты и расстояния
+    Render,     ///< настройки и заранее вычисленная карта
+    Routing,    ///< настройки маршрутизации и поездки, по которым строится граф
+};
+
+constexpr size_t SECTIONS_COUNT = 3;
+
+///[\brief] Записывает разделы базы, перечисленные в порядке Section, под общим оглавлением
+void WriteBase(std::ostream& stream, const std::array<transport_catalogue_serialize::Catalogue, SECTIONS_COUNT>& sections);
+
+// Читает разделы файла базы по мере надобности
+class BaseReader {
+public:
+    ///[\brief] Читает файл: оглавление и байты разделов, разбор которых откладывается до ReadSection.
+    ///         Файл прежнего формата без разделов разбирается сразу
+    explicit BaseReader(std::string path);
+
+    ///[\brief] Разбирает раздел. Может вызываться из нескольких потоков одновременно
+    std::shared_ptr<const transport_catalogue_serialize::Catalogue> ReadSection(Section section) const;
+
+private:
+    std::string path_;
+    // Разделы читаются вместе с оглавлением: подмена или изменение файла после открытия
+    // базы не смешает разделы разных версий
+    std::array<std::string, SECTIONS_COUNT> sections_;
+    std::shared_ptr<const transport_catalogue_serialize::Catalogue> whole_;
+};
+
 }   // namespace serialize
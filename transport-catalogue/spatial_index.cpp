@@ -0,0 +1,134 @@
+#define _USE_MATH_DEFINES
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+namespace geo {
+
+SpatialIndex::SpatialIndex(const std::vector<Coordinates>& points)
+    : split_axes_(points.size(), 0) {
+    points_.reserve(points.size());
+    for (size_t index = 0; index < points.size(); ++index) {
+        points_.push_back(ToPoint(points[index], index));
+    }
+    Build(0, points_.size());
+}
+
+std::vector<SpatialIndex::Neighbour> SpatialIndex::FindInRadius(Coordinates center, double radius) const {
+    std::vector<Neighbour> result;
+    ForEachInRadius(center, radius, [&result](size_t index, double distance) {
+        result.push_back({index, distance});
+    });
+    std::sort(result.begin(), result.end(), [](const Neighbour& lhs, const Neighbour& rhs) {
+        return std::tie(lhs.distance, lhs.index) < std::tie(rhs.distance, rhs.index);
+    });
+    return result;
+}
+
+std::vector<SpatialIndex::Neighbour> SpatialIndex::FindNearest(Coordinates center, size_t count) const {
+    // Куча с наибольшим квадратом хорды среди найденных на вершине
+    std::vector<std::pair<double, size_t>> heap;
+    heap.reserve(std::min(count, points_.size()) + 1);
+    if (count > 0) {
+        VisitNearest(ToPoint(center, 0), count, 0, points_.size(), heap);
+    }
+
+    std::sort_heap(heap.begin(), heap.end());
+    std::vector<Neighbour> result;
+    result.reserve(heap.size());
+    for (const auto& [squared, position] : heap) {
+        result.push_back({points_[position].index, ChordToDistance(squared)});
+    }
+    return result;
+}
+
+SpatialIndex::Point SpatialIndex::ToPoint(Coordinates coordinates, size_t index) {
+    static const double dr = M_PI / 180.;
+    const double lat = coordinates.lat * dr;
+    const double lng = coordinates.lng * dr;
+    return {{std::cos(lat) * std::cos(lng), std::cos(lat) * std::sin(lng), std::sin(lat)}, index};
+}
+
+double SpatialIndex::SquaredChord(const Point& lhs, const Point& rhs) {
+    const double dx = lhs.v[0] - rhs.v[0];
+    const double dy = lhs.v[1] - rhs.v[1];
+    const double dz = lhs.v[2] - rhs.v[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+double SpatialIndex::ChordToDistance(double squared_chord) {
+    // Хорда c стягивает дугу 2 * asin(c / 2)
+    const double half_chord = std::sqrt(squared_chord) / 2;
+    return 2 * std::asin(std::min(half_chord, 1.)) * EARTH_RADIUS;
+}
+
+double SpatialIndex::RadiusToSquaredChord(double radius) {
+    const double chord = 2 * std::sin(std::min(radius / EARTH_RADIUS, M_PI) / 2);
+    return chord * chord * (1 + 1e-9) + 1e-18;
+}
+
+void SpatialIndex::Build(size_t begin, size_t end) {
+    while (end - begin > 1) {
+        // Разбиваем по оси наибольшего разброса, чтобы поддеревья были компактнее
+        double min[3] = {2, 2, 2};
+        double max[3] = {-2, -2, -2};
+        for (size_t i = begin; i < end; ++i) {
+            for (int axis = 0; axis < 3; ++axis) {
+                min[axis] = std::min(min[axis], points_[i].v[axis]);
+                max[axis] = std::max(max[axis], points_[i].v[axis]);
+            }
+        }
+        uint8_t axis = 0;
+        for (uint8_t candidate = 1; candidate < 3; ++candidate) {
+            if (max[candidate] - min[candidate] > max[axis] - min[axis]) {
+                axis = candidate;
+            }
+        }
+
+        const size_t middle = begin + (end - begin) / 2;
+        std::nth_element(points_.begin() + begin, points_.begin() + middle, points_.begin() + end,
+                         [axis](const Point& lhs, const Point& rhs) { return lhs.v[axis] < rhs.v[axis]; });
+        split_axes_[middle] = axis;
+
+        Build(begin, middle);
+        begin = middle + 1;
+    }
+}
+
+void SpatialIndex::VisitNearest(const Point& center, size_t count, size_t begin, size_t end,
+                                std::vector<std::pair<double, size_t>>& heap) const {
+    while (begin < end) {
+        const size_t middle = begin + (end - begin) / 2;
+        const double squared = SquaredChord(center, points_[middle]);
+        if (heap.size() < count) {
+            heap.emplace_back(squared, middle);
+            std::push_heap(heap.begin(), heap.end());
+        } else if (squared < heap.front().first) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = {squared, middle};
+            std::push_heap(heap.begin(), heap.end());
+        }
+
+        const uint8_t axis = split_axes_[middle];
+        const double delta = center.v[axis] - points_[middle].v[axis];
+        // Сначала ближняя к центру сторона: после неё дальнюю часто удаётся отбросить
+        const bool left_first = delta < 0;
+        if (left_first) {
+            VisitNearest(center, count, begin, middle, heap);
+        } else {
+            VisitNearest(center, count, middle + 1, end, heap);
+        }
+        if (heap.size() == count && delta * delta >= heap.front().first) {
+            return;
+        }
+        if (left_first) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+}
+
+}  // namespace geo
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "geo.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+namespace geo {
+
+// Статический индекс точек на поверхности Земли: k-d дерево над единичными векторами точек.
+// Длина хорды монотонна по расстоянию на сфере, поэтому ближайшие по хорде точки — ближайшие
+// и на сфере, а поиск в радиусе сводится к поиску в шаре. Векторы вычисляются один раз при
+// построении, и расстояние до точки считается скалярным произведением без тригонометрии над ней
+class SpatialIndex {
+public:
+    // Найденная точка: индекс в исходном массиве и расстояние в метрах
+    struct Neighbour {
+        size_t index;
+        double distance;
+    };
+
+    SpatialIndex() = default;
+    explicit SpatialIndex(const std::vector<Coordinates>& points);
+
+    ///[\brief] Вызывает action(index, distance) для каждой точки, удалённой от center не более чем на radius метров
+    template <typename Action>
+    void ForEachInRadius(Coordinates center, double radius, Action action) const;
+
+    ///[\brief] Точки не дальше radius метров от center в порядке удаления
+    std::vector<Neighbour> FindInRadius(Coordinates center, double radius) const;
+    ///[\brief] Не более count ближайших к center точек в порядке удаления
+    std::vector<Neighbour> FindNearest(Coordinates center, size_t count) const;
+
+private:
+    struct Point {
+        double v[3];
+        size_t index;
+    };
+
+    static Point ToPoint(Coordinates coordinates, size_t index);
+    static double SquaredChord(const Point& lhs, const Point& rhs);
+    // Расстояние на сфере по квадрату хорды
+    static double ChordToDistance(double squared_chord);
+    // Квадрат хорды, стягивающей дугу radius, с небольшим запасом на погрешность вычислений
+    static double RadiusToSquaredChord(double radius);
+
+    // Поддерево занимает отрезок [begin, end) массива points_, его корень — середина отрезка
+    void Build(size_t begin, size_t end);
+    template <typename Action>
+    void VisitBall(const Point& center, double squared_chord, size_t begin, size_t end, Action& action) const;
+    void VisitNearest(const Point& center, size_t count, size_t begin, size_t end,
+                      std::vector<std::pair<double, size_t>>& heap) const;
+
+    std::vector<Point> points_;
+    std::vector<uint8_t> split_axes_;   ///< ось разбиения для корня каждого поддерева
+};
+
+template <typename Action>
+void SpatialIndex::ForEachInRadius(Coordinates center, double radius, Action action) const {
+    // Лишние точки, попавшие в шар из-за запаса в RadiusToSquaredChord, отсекаются по расстоянию
+    const double squared_chord = RadiusToSquaredChord(radius);
+    const Point center_point = ToPoint(center, 0);
+    auto filter = [&action, radius](const Point& point, double squared) {
+        const double distance = ChordToDistance(squared);
+        if (distance <= radius) {
+            action(point.index, distance);
+        }
+    };
+    VisitBall(center_point, squared_chord, 0, points_.size(), filter);
+}
+
+template <typename Action>
+void SpatialIndex::VisitBall(const Point& center, double squared_chord, size_t begin, size_t end, Action& action) const {
+    while (begin < end) {
+        const size_t middle = begin + (end - begin) / 2;
+        const Point& point = points_[middle];
+        const double squared = SquaredChord(center, point);
+        if (squared <= squared_chord) {
+            action(point, squared);
+        }
+
+        const uint8_t axis = split_axes_[middle];
+        const double delta = center.v[axis] - point.v[axis];
+        // Поддерево по ту же сторону от плоскости разбиения, что и центр, просматривается всегда,
+        // противоположное — только если шар пересекает плоскость
+        const bool left_first = delta < 0;
+        if (delta * delta <= squared_chord) {
+            if (left_first) {
+                VisitBall(center, squared_chord, middle + 1, end, action);
+            } else {
+                VisitBall(center, squared_chord, begin, middle, action);
+            }
+        }
+        if (left_first) {
+            end = middle;
+        } else {
+            begin = middle + 1;
+        }
+    }
+}
+
+}  // namespace geo
@@ -1,18 +1,41 @@
 #include "svg.h"
 
 #include <algorithm>
+#include <array>
+#include <string_view>
 #include <unordered_map>
 
 namespace svg {
 
 using namespace std::literals;
 
-static const std::unordered_map<char, std::string> text_replace_symbols = {
-    {'\"', "&quot;"},
-    {'\'', "&apos;"},
-    {'<', "&lt;"},
-    {'>', "&gt;"},
-    {'&', "&amp;"}};
+// Замены для символов, которые нельзя выводить в тексте svg как есть.
+// Индексом служит код символа, для остальных символов строка замены пуста
+static const std::array<std::string_view, 256> text_replace_symbols = [] {
+    std::array<std::string_view, 256> symbols{};
+    symbols[static_cast<unsigned char>('\"')] = "&quot;"sv;
+    symbols[static_cast<unsigned char>('\'')] = "&apos;"sv;
+    symbols[static_cast<unsigned char>('<')] = "&lt;"sv;
+    symbols[static_cast<unsigned char>('>')] = "&gt;"sv;
+    symbols[static_cast<unsigned char>('&')] = "&amp;"sv;
+    return symbols;
+}();
+
+// Выводит текст, экранируя спецсимволы. Участки без спецсимволов копируются целиком
+static void RenderEscapedText(std::ostream& out, std::string_view text) {
+    const char* run_begin = text.data();
+    const char* const end = text.data() + text.size();
+    for (const char* it = run_begin; it != end; ++it) {
+        const std::string_view replacement = text_replace_symbols[static_cast<unsigned char>(*it)];
+        if (replacement.empty()) {
+            continue;
+        }
+        out.write(run_begin, it - run_begin);
+        out.write(replacement.data(), replacement.size());
+        run_begin = it + 1;
+    }
+    out.write(run_begin, end - run_begin);
+}
 
 static const std::unordered_map<StrokeLineCap, std::string> map_StrokeLineCap = {
     {StrokeLineCap::BUTT, "butt"},
@@ -113,18 +136,8 @@ Text &Text::SetData(std::string data)
     auto first_symbol = data.find_first_not_of(' ');
     auto last_symbol = data.find_last_not_of(' ');
 
-    data = data.substr(first_symbol, last_symbol - first_symbol + 1);
-
-    size_t iter = data.size();
-    while (iter > 0){
-        --iter;
-        if (text_replace_symbols.count(data[iter])) {
-            char tmp = data[iter];
-            data.erase(iter, 1);
-            data.insert(iter, text_replace_symbols.at(tmp));
-        }
-    }
-    this->data = data;
+    // Спецсимволы экранируются при выводе, здесь хранится исходный текст
+    this->data = data.substr(first_symbol, last_symbol - first_symbol + 1);
     return *this;
 }
 
@@ -144,7 +157,7 @@ void Text::RenderObject(const RenderContext &context) const
     if (!font_weight.empty())
         out << " font-weight=\"" << font_weight << "\"";
     out << ">"sv;
-    out << data;
+    RenderEscapedText(out, data);
     out << "</text>"sv;
 }
 
@@ -155,15 +168,27 @@ void Document::AddPtr(std::unique_ptr<Object> &&obj)
 
 void Document::Render(std::ostream &out) const
 {
-    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
-    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
+    RenderHeader(out);
+    RenderObjects(out);
+    RenderFooter(out);
+}
 
+void Document::RenderObjects(std::ostream &out) const
+{
     for(auto &obj_ptr : objects){
         obj_ptr.get()->Render({out,2,2});
     }
+}
 
-    out << "</svg>"sv;
+void Document::RenderHeader(std::ostream &out)
+{
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
+    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
+}
 
+void Document::RenderFooter(std::ostream &out)
+{
+    out << "</svg>"sv;
 }
 
 std::ostream &operator<<(std::ostream &out, const StrokeLineCap &val)
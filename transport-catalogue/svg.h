@@ -42,10 +42,10 @@ struct Point {
         , y(y) {
     }
 
-    bool operator==(const Point& other){
+    bool operator==(const Point& other) const {
         return x == other.x && y == other.y;
     }
-    bool operator!=(const Point& other){
+    bool operator!=(const Point& other) const {
         return x != other.x || y != other.y;
     }
 
@@ -267,6 +267,13 @@ public:
 
     // Выводит в ostream svg-представление документа
     void Render(std::ostream& out) const;
+
+    // Выводит в ostream только теги объектов документа, без заголовка и закрывающего тега svg.
+    // Позволяет собирать документ из фрагментов, подготовленных независимо друг от друга
+    void RenderObjects(std::ostream& out) const;
+
+    static void RenderHeader(std::ostream& out);
+    static void RenderFooter(std::ostream& out);
 };
 
 
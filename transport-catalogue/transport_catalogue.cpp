@@ -12,7 +12,7 @@ void TransportCatalogue::AddStop(const std::string_view name, const geo::Coordin
     assert(!name.empty());
     stops.push_back({std::string(name), coord});
     stopname_to_stop[stops.back().name] = &stops.back();
-    stop_to_buses[stops.back().name];
+    stop_to_buses[&stops.back()];
 }
 
 void TransportCatalogue::AddDistance(const std::string_view from, const std::string_view to, const double l)
@@ -27,6 +27,22 @@ void TransportCatalogue::AddDistance(const std::string_view from, const std::str
     }
 }
 
+void TransportCatalogue::Reserve(size_t stops_count, size_t buses_count, size_t distances_count)
+{
+    stopname_to_stop.reserve(stops.size() + stops_count);
+    stop_to_buses.reserve(stops.size() + stops_count);
+    busname_to_bus.reserve(buses.size() + buses_count);
+    stops_to_distance.reserve(stops_to_distance.size() + distances_count);
+}
+
+void TransportCatalogue::AddDistance(size_t from, size_t to, double l)
+{
+    if (l < 0 || l > maxRouteDistance){
+        throw std::invalid_argument("invalid distance value: " + std::to_string(l) + " between " + stops.at(from).name + " and " + stops.at(to).name);
+    }
+    stops_to_distance[{&stops.at(from), &stops.at(to)}] = l;
+}
+
 std::optional<TransportCatalogue::Stop> TransportCatalogue::FindStop(const std::string_view name) const
 {
     if (stopname_to_stop.count(name)) {
@@ -45,11 +61,11 @@ std::optional<TransportCatalogue::Bus> TransportCatalogue::FindBus(const std::st
 
 std::optional<StopStat> TransportCatalogue::GetStopInfo(const std::string_view name) const
 {
-    const auto &stop = FindStop(name);
-    if (stop == std::nullopt){
+    const auto stop = stopname_to_stop.find(name);
+    if (stop == stopname_to_stop.end()){
         return std::nullopt;
     } else {
-        auto& buses = stop_to_buses.at(std::string(name));
+        auto& buses = stop_to_buses.at(stop->second);
         std::vector<std::string> res(buses.size());
         std::transform(buses.begin(), buses.end(),
                        res.begin(),
@@ -60,7 +76,7 @@ std::optional<StopStat> TransportCatalogue::GetStopInfo(const std::string_view n
 
         std::sort(res.begin(), res.end());
         res.erase(std::unique(res.begin(), res.end()), res.end());
-        return StopStat{std::string(name), res, stopname_to_stop.at(name)->coordinates};
+        return StopStat{stop->second->name, res, stop->second->coordinates};
     }
 }
 
@@ -82,7 +98,7 @@ std::optional<BusStat> TransportCatalogue::GetBusInfo(const std::string_view nam
             } else if (stops_to_distance.count({(*r_iter), (*l_iter)})) {
                 route_length += stops_to_distance.at({(*r_iter), (*l_iter)});
             } else {
-                route_length += geo_length;
+                route_length += geo::ComputeDistance((*l_iter)->coordinates, (*r_iter)->coordinates);
             }
 
             l_iter = r_iter;
@@ -107,7 +123,7 @@ std::optional<BusStat> TransportCatalogue::GetBusInfo(const std::string_view nam
                 } else if (stops_to_distance.count({(*r_iter), (*l_iter)})) {
                     route_length += stops_to_distance.at({(*r_iter), (*l_iter)});
                 } else {
-                    route_length += geo_length;
+                    route_length += geo::ComputeDistance((*l_iter)->coordinates, (*r_iter)->coordinates);
                 }
 
                 l_iter = r_iter;
@@ -142,6 +158,16 @@ double TransportCatalogue::GetDistanceBetweenStops(const std::string_view from_s
         return geo::ComputeDistance(from_stop_ptr->coordinates, to_stop_ptr->coordinates);
 }
 
+std::vector<std::tuple<std::string_view, std::string_view, double>> TransportCatalogue::GetDistances() const
+{
+    std::vector<std::tuple<std::string_view, std::string_view, double>> res;
+    res.reserve(stops_to_distance.size());
+    for (const auto &[stops, distance] : stops_to_distance) {
+        res.emplace_back(stops.first->name, stops.second->name, distance);
+    }
+    return res;
+}
+
 std::vector<std::string> TransportCatalogue::GetStops() const
 {
     std::vector<std::string> res(stops.size());
@@ -151,6 +177,11 @@ std::vector<std::string> TransportCatalogue::GetStops() const
     return res;
 }
 
+size_t TransportCatalogue::GetStopsCount() const
+{
+    return stops.size();
+}
+
 std::optional<Coordinates> TransportCatalogue::GetStopCoordinates(const std::string_view name) const
 {
     if (stopname_to_stop.count(name))
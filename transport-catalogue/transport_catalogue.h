@@ -45,14 +45,27 @@ namespace catalogue {
         void AddBus(const std::string_view name, const RouteType type, const Container &stops);
         ///[\brief] Добавление расстояния между остановками
         void AddDistance(const std::string_view from, const std::string_view to, const double distance);
+
+        // Массовая загрузка: остановки задаются порядковыми номерами в порядке их добавления,
+        // так что поиск по именам не нужен
+        ///[\brief] Резервирует место под заранее известное число остановок, маршрутов и расстояний
+        void Reserve(size_t stops_count, size_t buses_count, size_t distances_count);
+        ///[\brief] Добавление расстояния между остановками с номерами from и to
+        void AddDistance(size_t from, size_t to, double distance);
+        ///[\brief] Добавляет маршрут по номерам остановок
+        template<typename Indices>
+        void AddBusByIndices(const std::string_view name, const RouteType type, const Indices &stop_indices);
         std::optional<Stop> FindStop(const std::string_view stop_name) const;
         std::optional<Bus> FindBus(const std::string_view bus_name) const;
         std::optional<StopStat> GetStopInfo(const std::string_view stop_name) const;
         std::optional<BusStat> GetBusInfo(const std::string_view bus_name) const;
         RouteType GetBusType(const std::string_view bus_name) const;
         double GetDistanceBetweenStops(const std::string_view from_stop, const std::string_view to_stop) const;
+        ///[\brief] Явно заданные расстояния между остановками: откуда, куда, длина
+        std::vector<std::tuple<std::string_view, std::string_view, double>> GetDistances() const;
 
         std::vector<std::string> GetStops() const;
+        size_t GetStopsCount() const;
         std::optional<Coordinates> GetStopCoordinates(const std::string_view stop_name) const;
 
         std::vector<std::string> GetBuses() const;
@@ -65,11 +78,29 @@ namespace catalogue {
         std::unordered_map<std::string_view, Stop*> stopname_to_stop;
         std::unordered_map<std::string_view, Bus*> busname_to_bus;
 
-        std::unordered_map<std::string_view, std::deque<std::string_view>> stop_to_buses;
+        // Маршруты, проходящие через остановку, в порядке добавления, возможно с повторами
+        std::unordered_map<const Stop*, std::deque<std::string_view>> stop_to_buses;
 
         std::unordered_map<std::pair<Stop*, Stop*>, double, StopToStopHasher> stops_to_distance;
     };
 
+    //======================================================================
+    template<typename Indices>
+    inline void TransportCatalogue::AddBusByIndices(const std::string_view name, const RouteType type, const Indices &stop_indices)
+    {
+        assert(!name.empty());
+        assert(stop_indices.size() > 1);
+
+        Bus &bus = buses.emplace_back(Bus{std::string(name), type, std::vector<Stop*>()});
+        busname_to_bus[bus.name] = &bus;
+        bus.stops.reserve(stop_indices.size());
+        for (const auto index : stop_indices) {
+            Stop *stop = &stops.at(index);
+            bus.stops.push_back(stop);
+            stop_to_buses[stop].push_back(bus.name);
+        }
+    }
+
     //======================================================================
     template<typename Container>
     inline void TransportCatalogue::AddBus(const std::string_view name, const RouteType type, const Container &stops_)
@@ -87,7 +118,7 @@ namespace catalogue {
         {
             return stopname_to_stop.at(stop_name);
         });
-        for(const auto& stop : stops_){
+        for(const Stop* stop : *stops){
             stop_to_buses[stop].push_back(buses.back().name);
         }
     }
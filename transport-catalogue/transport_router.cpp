@@ -1,12 +1,11 @@
 #include "transport_router.h"
 #include "router.h"
+#include "spatial_index.h"
 
 #include <algorithm>
 
 namespace router {
 
-static constexpr double SPEED_TRANSFORM_KOEFFICIENT = 1000.0 / 60.0;
-
 TransportRouter &TransportRouter::SetBusWaitTime(double value)
 {
     bus_params_.wait_time = value;
@@ -19,6 +18,18 @@ TransportRouter &TransportRouter::SetBusVelocity(double value)
     return *this;
 }
 
+TransportRouter &TransportRouter::SetWalkRadius(double value)
+{
+    walk_params_.radius = value;
+    return *this;
+}
+
+TransportRouter &TransportRouter::SetWalkingVelocity(double value)
+{
+    walk_params_.velocity = value;
+    return *this;
+}
+
 void TransportRouter::RouteCatalogue(catalogue::TransportCatalogue &catalogue)
 {
     using namespace graph;
@@ -26,10 +37,13 @@ void TransportRouter::RouteCatalogue(catalogue::TransportCatalogue &catalogue)
     SetStops(catalogue.GetStops());
     SetBuses(catalogue.GetBuses());
 
-    graph_ = DirectedWeightedGraph<double>(stops_.size());
+    graph_ = Graph(stops_.size());
+    route_info_.clear();
 
-    for (const std::string_view bus : buses_){
-        const auto& bus_info = catalogue.FindBus(bus);
+    const double koeff = 1 / (bus_params_.velocity * SPEED_TRANSFORM_KOEFFICIENT);
+
+    for (size_t bus_index = 0; bus_index < buses_.size(); ++bus_index){
+        const auto& bus_info = catalogue.FindBus(buses_[bus_index]);
         if (!bus_info)
             continue;
         if (bus_info->stops.empty())
@@ -37,11 +51,12 @@ void TransportRouter::RouteCatalogue(catalogue::TransportCatalogue &catalogue)
 
         const auto& bus_stops = bus_info->stops;
 
+        // Список остановок упорядочен, поэтому индекс находится двоичным поиском
         std::vector<size_t> bus_stops_indexes(bus_stops.size());
         std::transform(bus_stops.begin(), bus_stops.end(),
                        bus_stops_indexes.begin(),
                        [this](const auto stop){
-            return std::distance(stops_.begin(), std::find(stops_.begin(), stops_.end(), stop->name));
+            return std::distance(stops_.begin(), std::lower_bound(stops_.begin(), stops_.end(), stop->name));
         });
 
         for (size_t left_index = 0; left_index < bus_stops.size(); ++left_index){
@@ -53,31 +68,12 @@ void TransportRouter::RouteCatalogue(catalogue::TransportCatalogue &catalogue)
                 auto left_stop_index = bus_stops_indexes[left_index];
                 auto right_stop_index = bus_stops_indexes[right_index];
 
-                const double koeff = 1 / (bus_params_.velocity * SPEED_TRANSFORM_KOEFFICIENT);
-
                 forward_time += catalogue.GetDistanceBetweenStops(prev_stop, bus_stops.at(right_index)->name) * koeff;
                 backward_time += catalogue.GetDistanceBetweenStops(bus_stops.at(right_index)->name, prev_stop) * koeff;
 
-                auto forward_route = graph_.AddEdge({left_stop_index,
-                                                     right_stop_index,
-                                                     forward_time + bus_params_.wait_time});
-                route_info_[forward_route] = {
-                    stops_.at(left_stop_index),
-                    stops_.at(right_stop_index),
-                    bus,
-                    span_count,
-                    forward_time};
-
+                AddRoute({left_stop_index, right_stop_index, bus_index, span_count, forward_time});
                 if (bus_info->type == Linear){
-                    auto backward_route = graph_.AddEdge({right_stop_index,
-                                                          left_stop_index,
-                                                          backward_time + bus_params_.wait_time});
-                    route_info_[backward_route] = {
-                        stops_.at(right_stop_index),
-                        stops_.at(left_stop_index),
-                        bus,
-                        span_count,
-                        backward_time};
+                    AddRoute({right_stop_index, left_stop_index, bus_index, span_count, backward_time});
                 }
 
                 prev_stop = bus_stops.at(right_index)->name;
@@ -85,18 +81,31 @@ void TransportRouter::RouteCatalogue(catalogue::TransportCatalogue &catalogue)
             }
         }
     }
+
+    if (walk_params_.radius > 0 && walk_params_.velocity > 0){
+        AddWalks(catalogue);
+    }
+}
+
+void TransportRouter::BuildRouter()
+{
+    std::call_once(graph_router_once_, [this]{
+        graph_.Freeze();
+        graph_router_ = std::make_unique<graph::Router<Weight, Graph::VertexId>>(graph_);
+    });
 }
 
 std::optional<RouteInfo> TransportRouter::MakeRoute(const std::string &from_stop, const std::string &to_stop)
 {
-    if (!graph_router_){
-        graph_router_ = std::make_unique<graph::Router<double>>(graph_);
-    }
+    BuildRouter();
 
-    auto from_index = std::distance(stops_.begin(), std::find(stops_.begin(), stops_.end(), from_stop));
-    auto to_index = std::distance(stops_.begin(), std::find(stops_.begin(), stops_.end(), to_stop));
+    const auto from_index = FindStop(from_stop);
+    const auto to_index = FindStop(to_stop);
+    if (!from_index || !to_index){
+        return std::nullopt;
+    }
 
-    auto route = graph_router_->BuildRoute(from_index, to_index);
+    auto route = graph_router_->BuildRoute(*from_index, *to_index);
 
     if (route == std::nullopt){
         return std::nullopt;
@@ -106,51 +115,67 @@ std::optional<RouteInfo> TransportRouter::MakeRoute(const std::string &from_stop
     for (const auto edge : route->edges){
         const RouteParams& edge_info = route_info_.at(edge);
 
-        route_info.buses.push_back(
-                    router::RouteInfo::BusInfo{edge_info.bus,
-                                               edge_info.span_count,
-                                               edge_info.time});
+        if (edge_info.IsWalk()){
+            route_info.items.push_back(
+                        router::RouteInfo::WalkInfo{stops_.at(edge_info.from_stop),
+                                                    stops_.at(edge_info.to_stop),
+                                                    edge_info.time});
+            continue;
+        }
 
-        route_info.stops.push_back(
-                    router::RouteInfo::StopInfo{edge_info.from_stop,
+        route_info.items.push_back(
+                    router::RouteInfo::StopInfo{stops_.at(edge_info.from_stop),
                                                 bus_params_.wait_time});
 
+        route_info.items.push_back(
+                    router::RouteInfo::BusInfo{buses_.at(edge_info.bus),
+                                               edge_info.span_count,
+                                               edge_info.time});
+
     }
     return route_info;
 }
 
-const graph::DirectedWeightedGraph<double> &TransportRouter::GetGraph() const
+std::optional<TransportRouter::Graph::VertexId> TransportRouter::FindStop(const std::string &name) const
 {
-    return graph_;
+    // Остановки упорядочены по названию
+    const auto it = std::lower_bound(stops_.begin(), stops_.end(), name);
+    if (it == stops_.end() || *it != name){
+        return std::nullopt;
+    }
+    return static_cast<Graph::VertexId>(std::distance(stops_.begin(), it));
 }
 
-graph::DirectedWeightedGraph<double> &TransportRouter::GetGraph()
+const TransportRouter::Graph &TransportRouter::GetGraph() const
 {
     return graph_;
 }
 
-const TransportRouter::RouteParams& TransportRouter::GetRouteParams(const graph::EdgeId edge) const
+TransportRouter::Graph &TransportRouter::GetGraph()
 {
-    return route_info_.at(edge);
+    return graph_;
 }
 
-const size_t TransportRouter::GetRouteParamsCount() const
+const std::vector<TransportRouter::RouteParams> &TransportRouter::GetRouteParams() const
 {
-    return route_info_.size();
+    return route_info_;
 }
 
-void TransportRouter::SetRouteParams(const graph::EdgeId edge_id, const RouteParams &params)
+void TransportRouter::AddRoute(const RouteParams &params)
 {
-    route_info_[edge_id] = std::move(params);
+    using Id = Graph::VertexId;
+    const double wait_time = params.IsWalk() ? 0 : bus_params_.wait_time;
+    graph_.AddEdge({static_cast<Id>(params.from_stop), static_cast<Id>(params.to_stop), params.time + wait_time});
+    route_info_.push_back(params);
 }
 
-void TransportRouter::SetStops(const std::vector<std::string> &stops)
+void TransportRouter::SetStops(std::vector<std::string> stops)
 {
     stops_ = std::move(stops);
     std::sort(stops_.begin(), stops_.end());
 }
 
-void TransportRouter::SetBuses(const std::vector<std::string> &buses)
+void TransportRouter::SetBuses(std::vector<std::string> buses)
 {
     buses_ = std::move(buses);
     std::sort(buses_.begin(), buses_.end());
@@ -176,4 +201,34 @@ double TransportRouter::GetBusVelocity() const
     return bus_params_.velocity;
 }
 
+double TransportRouter::GetWalkRadius() const
+{
+    return walk_params_.radius;
+}
+
+double TransportRouter::GetWalkingVelocity() const
+{
+    return walk_params_.velocity;
+}
+
+void TransportRouter::AddWalks(const catalogue::TransportCatalogue &catalogue)
+{
+    std::vector<geo::Coordinates> coordinates;
+    coordinates.reserve(stops_.size());
+    for (const std::string& stop : stops_){
+        coordinates.push_back(catalogue.GetStopCoordinates(stop).value_or(geo::Coordinates{0, 0}));
+    }
+
+    // Для каждой остановки просматриваются только ближайшие ветви индекса, а не все остановки
+    const double koeff = 1 / (walk_params_.velocity * SPEED_TRANSFORM_KOEFFICIENT);
+    const geo::SpatialIndex index(coordinates);
+    for (size_t from = 0; from < stops_.size(); ++from){
+        index.ForEachInRadius(coordinates[from], walk_params_.radius, [&](size_t to, double distance){
+            if (to != from){
+                AddRoute({from, to, 0, 0, distance * koeff});
+            }
+        });
+    }
+}
+
 } // namespace router
@@ -5,11 +5,19 @@
 #include "graph.h"
 #include "router.h"
 
+#include <cstdint>
 #include <deque>
-#include <map>
+#include <mutex>
+#include <variant>
+#include <vector>
 
 namespace router {
+
+// Переводит скорость из км/ч в м/мин
+static constexpr double SPEED_TRANSFORM_KOEFFICIENT = 1000.0 / 60.0;
+
 struct RouteInfo{
+    // Ожидание автобуса на остановке
     struct StopInfo{
         std::string_view name;
         double time;
@@ -19,42 +27,70 @@ struct RouteInfo{
         size_t span_count;
         double time;
     };
+    struct WalkInfo{
+        std::string_view from;
+        std::string_view to;
+        double time;
+    };
+
+    using Item = std::variant<StopInfo, BusInfo, WalkInfo>;
 
-    std::deque<StopInfo> stops;
-    std::deque<BusInfo> buses;
+    std::deque<Item> items;     ///< элементы маршрута в порядке следования
     double total_time;
 };
 
 class TransportRouter{
+public:
+    // Номера вершин и рёбер помещаются в 32 бита. Время остаётся double: у float около семи
+    // значащих цифр, а выводится шесть, и ошибка, накопленная по рёбрам маршрута, дошла бы до вывода
+    using Weight = double;
+    using Graph = graph::DirectedWeightedGraph<Weight, uint32_t>;
+
+    // Поездка без пересадок, соответствующая ребру графа. Остановки и маршрут заданы
+    // индексами в GetStops() и GetBuses(). Переход пешком между остановками не проезжает
+    // ни одного пролёта и не связан с маршрутом
     struct RouteParams {
-        std::string_view from_stop;
-        std::string_view to_stop;
-        std::string_view bus;
+        size_t from_stop;
+        size_t to_stop;
+        size_t bus;
         size_t span_count;
         double time;
+
+        bool IsWalk() const {
+            return span_count == 0;
+        }
     };
 
-public:
     TransportRouter& SetBusWaitTime(double);
     TransportRouter& SetBusVelocity(double);
+    // Переходы пешком строятся между остановками не дальше radius метров друг от друга.
+    // При нулевом радиусе или скорости переходов нет
+    TransportRouter& SetWalkRadius(double);
+    TransportRouter& SetWalkingVelocity(double);
     void RouteCatalogue(catalogue::TransportCatalogue& catalogue);
     std::optional<RouteInfo> MakeRoute(const std::string& from_stop, const std::string& to_stop);
+    // Строит маршрутизатор графа, если он ещё не построен. Иначе это делает первый вызов MakeRoute
+    void BuildRouter();
 
-    const graph::DirectedWeightedGraph<double>& GetGraph() const;
-    graph::DirectedWeightedGraph<double> &GetGraph();
+    const Graph& GetGraph() const;
+    Graph &GetGraph();
 
-    const RouteParams &GetRouteParams(const graph::EdgeId) const;
-    const size_t GetRouteParamsCount() const;
-    void SetRouteParams(const graph::EdgeId edge_id, const RouteParams& params);
+    // Параметры поездок по порядку рёбер графа
+    const std::vector<RouteParams> &GetRouteParams() const;
+    // Добавляет поездку и соответствующее ей ребро графа с учётом времени ожидания автобуса.
+    // Переход пешком ожидания не требует
+    void AddRoute(const RouteParams& params);
 
-    void SetStops(const std::vector<std::string>& stops);
-    void SetBuses(const std::vector<std::string>& buses);
+    void SetStops(std::vector<std::string> stops);
+    void SetBuses(std::vector<std::string> buses);
 
     const std::vector<std::string>& GetStops() const;
     const std::vector<std::string>& GetBuses() const;
 
     double GetBusWaitTime() const;
     double GetBusVelocity() const;
+    double GetWalkRadius() const;
+    double GetWalkingVelocity() const;
 
 
 private:
@@ -63,12 +99,24 @@ private:
         double velocity = 0;
     } bus_params_;
 
-    graph::DirectedWeightedGraph<double> graph_;
-    std::unique_ptr<graph::Router<double>> graph_router_;
+    struct {
+        double radius = 0;
+        double velocity = 0;
+    } walk_params_;
+
+    // Добавляет переходы пешком между близкими остановками
+    void AddWalks(const catalogue::TransportCatalogue& catalogue);
+    // Вершина графа остановки; пусто, если остановка не известна
+    std::optional<Graph::VertexId> FindStop(const std::string& name) const;
+
+    Graph graph_;
+    // Строится при первом поиске маршрута, в том числе когда поиски идут из нескольких потоков
+    std::unique_ptr<graph::Router<Weight, Graph::VertexId>> graph_router_;
+    std::once_flag graph_router_once_;
 
     std::vector<std::string> stops_;
     std::vector<std::string> buses_;
 
-    std::map<graph::EdgeId, RouteParams> route_info_;
+    std::vector<RouteParams> route_info_;
 };
 } // namespace router